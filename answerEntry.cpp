@@ -0,0 +1,142 @@
+#include "answerEntry.h"
+#include "sudokuOcr.h"
+#include "deviceSession.h"
+#include <cstdio>
+#include <iostream>
+#include <limits>
+
+int keypad_left = 13;
+int keypad_top = -1;  // по умолчанию цифры вводятся keyevent'ами
+int keypad_key_width = 117;
+int keypad_key_height = 150;
+int input_delay_ms = 0;
+
+bool RecordingSink::send(const std::string &command)
+{
+  out << command << "\n";
+  return static_cast<bool>(out);
+}
+
+bool RecordingSink::flush()
+{
+  out.flush();
+  return static_cast<bool>(out);
+}
+
+std::vector<Tap> plan_taps(const int board[9][9], const bool original_cells[9][9])
+{
+  std::vector<Tap> pending;
+  for (int row = 0; row < 9; row++)
+  {
+    for (int col = 0; col < 9; col++)
+    {
+      if (original_cells[row][col] || board[row][col] == 0)
+      {
+        continue;
+      }
+      Tap tap;
+      tap.row = row;
+      tap.column = col;
+      tap.digit = board[row][col];
+      tap.x = getOffset(col, cell_size, thick, thin, margin_left) + cell_size / 2;
+      tap.y = getOffset(row, cell_size, thick, thin, margin_top) + cell_size / 2;
+      pending.push_back(tap);
+    }
+  }
+
+  // Nearest neighbour from the top-left corner
+  std::vector<Tap> ordered;
+  int x = margin_left;
+  int y = margin_top;
+  while (!pending.empty())
+  {
+    size_t nearest = 0;
+    long best = std::numeric_limits<long>::max();
+    for (size_t i = 0; i < pending.size(); i++)
+    {
+      long dx = pending[i].x - x;
+      long dy = pending[i].y - y;
+      if (dx * dx + dy * dy < best)
+      {
+        best = dx * dx + dy * dy;
+        nearest = i;
+      }
+    }
+    ordered.push_back(pending[nearest]);
+    x = pending[nearest].x;
+    y = pending[nearest].y;
+    pending.erase(pending.begin() + nearest);
+  }
+  return ordered;
+}
+
+bool enter_solution(const std::vector<Tap> &taps, InputSink &sink)
+{
+  std::string delay;
+  if (input_delay_ms > 0)
+  {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "sleep %g", input_delay_ms / 1000.0);
+    delay = buf;
+  }
+
+  for (const Tap &tap : taps)
+  {
+    bool sent = sink.send("input tap " + std::to_string(tap.x) + " " + std::to_string(tap.y));
+
+    if (keypad_top < 0)
+    {
+      sent = sent && sink.send("input keyevent KEYCODE_" + std::to_string(tap.digit));
+    }
+    else
+    {
+      int key_x = keypad_left + (tap.digit - 1) * keypad_key_width + keypad_key_width / 2;
+      int key_y = keypad_top + keypad_key_height / 2;
+      sent = sent && sink.send("input tap " + std::to_string(key_x) + " " + std::to_string(key_y));
+    }
+
+    if (sent && !delay.empty())
+    {
+      sent = sink.send(delay);
+    }
+    if (!sent)
+    {
+      std::cerr << "Failed sending input for cell " << tap.row << "," << tap.column << std::endl;
+      return false;
+    }
+  }
+  return sink.flush();
+}
+
+bool load_device_geometry(DeviceSession &device, const std::string &layout)
+{
+  std::string output;
+  if (!device.execute("wm size", output))
+  {
+    return false;
+  }
+
+  // "Physical size: 1080x2400", иногда следом "Override size: ..." — она и действует
+  int width = 0, height = 0;
+  size_t start = 0;
+  while (start < output.size())
+  {
+    size_t end = output.find('\n', start);
+    std::string line = output.substr(start, end - start);
+    int w, h;
+    if (sscanf(line.c_str(), "%*[^:]: %dx%d", &w, &h) == 2)
+    {
+      width = w;
+      height = h;
+    }
+    start = end == std::string::npos ? output.size() : end + 1;
+  }
+
+  if (width == 0 || !loadGridCalibration(width, height, layout))
+  {
+    std::cerr << "No grid calibration for " << width << "x" << height << " " << layout
+              << ", using default geometry" << std::endl;
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+// Ввод решения на устройстве: координаты нажатий по геометрии сетки
+// (getOffset из sudokuOcr) и поток команд input в одну сессию adb shell
+// (DeviceSession).
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Экранная клавиатура игры. keypad_top < 0 — цифры вводятся keyevent'ами.
+extern int keypad_left;
+extern int keypad_top;
+extern int keypad_key_width;
+extern int keypad_key_height;
+extern int input_delay_ms;  // пауза между событиями, 0 — без пауз
+
+class DeviceSession;
+
+struct Tap {
+  int row;
+  int column;
+  int digit;
+  int x;  // центр ячейки на экране устройства
+  int y;
+};
+
+/**
+ * Receives shell commands (one "input ..." line per event)
+ */
+class InputSink
+{
+public:
+  virtual ~InputSink() {}
+  virtual bool send(const std::string &command) = 0;
+  virtual bool flush() { return true; }
+};
+
+/**
+ * Dry-run sink: records the event stream instead of sending it to a device
+ */
+class RecordingSink : public InputSink
+{
+public:
+  explicit RecordingSink(std::ostream &out) : out(out) {}
+
+  bool send(const std::string &command) override;
+  bool flush() override;
+
+private:
+  std::ostream &out;
+};
+
+/**
+ * Builds taps for every solver-filled cell, ordered greedily by distance
+ * from the previous tap so the sequence sweeps the board instead of jumping
+ */
+std::vector<Tap> plan_taps(const int board[9][9], const bool original_cells[9][9]);
+
+/**
+ * Sends a cell tap and a digit event for every planned tap
+ */
+bool enter_solution(const std::vector<Tap> &taps, InputSink &sink);
+
+/**
+ * Reads the device resolution ("wm size") and loads the grid
+ * calibration cached for it by matchTemplate
+ */
+bool load_device_geometry(DeviceSession &device, const std::string &layout);
@@ -0,0 +1,379 @@
+#include "batchScan.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <opencv2/opencv.hpp>
+#include "sudokuOcr.h"
+#include "ocrResolve.h"
+#include "pipelineTrace.h"
+
+int batch_decode_workers = 2;
+int batch_recognize_workers = 2;
+int batch_solve_workers = 1;
+int batch_queue_capacity = 8;
+double batch_low_confidence = 0.95;
+
+namespace {
+
+enum BatchStage { BATCH_DECODE = 0, BATCH_LOCATE, BATCH_RECOGNIZE, BATCH_SOLVE, BATCH_STAGES };
+const char* BATCH_STAGE_NAMES[BATCH_STAGES] = {"decode", "locate", "recognize", "solve"};
+
+// Один снимок, переходящий со стадии на стадию
+struct BatchItem {
+  size_t index;
+  std::string path;
+  cv::Mat image;
+  bool decoded = false;
+  bool gridFound = false;
+  GridGeometry geometry;  // геометрия, найденная для этого снимка
+  bool recognized = false;
+  ScannedBoard board;
+  bool resolved = false;
+  Resolution resolution;  // доска после исправления сомнительных ячеек и её решение
+  double stageMs[BATCH_STAGES] = {};
+};
+
+typedef std::unique_ptr<BatchItem> ItemPtr;
+
+// Очередь ограниченного размера: push ждёт, пока есть место, pop — пока
+// есть элементы. Закрывается, когда отработали все производители.
+class BoundedQueue {
+ public:
+  BoundedQueue(size_t capacity, int producers) : capacity(capacity), producers(producers) {}
+
+  void push(ItemPtr item, std::atomic<uint64_t>& waitNs) {
+    uint64_t start = traceNow();
+    std::unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [this] { return items.size() < capacity; });
+    waitNs += traceNow() - start;
+    items.push_back(std::move(item));
+    notEmpty.notify_one();
+  }
+
+  // false, когда очередь закрыта и пуста
+  bool pop(ItemPtr& item, std::atomic<uint64_t>& waitNs) {
+    uint64_t start = traceNow();
+    std::unique_lock<std::mutex> lock(mutex);
+    notEmpty.wait(lock, [this] { return !items.empty() || producers == 0; });
+    waitNs += traceNow() - start;
+    if (items.empty()) {
+      return false;
+    }
+    item = std::move(items.front());
+    items.pop_front();
+    notFull.notify_one();
+    return true;
+  }
+
+  void producerDone() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--producers == 0) {
+      notEmpty.notify_all();
+    }
+  }
+
+ private:
+  size_t capacity;
+  int producers;
+  std::deque<ItemPtr> items;
+  std::mutex mutex;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+};
+
+// Время стадии: работа, ожидание входа (стадия простаивает — узкое место выше)
+// и ожидание места в выходной очереди (узкое место ниже)
+struct StageStats {
+  int workers = 1;
+  std::atomic<uint64_t> items{0};
+  std::atomic<uint64_t> busyNs{0};
+  std::atomic<uint64_t> inputWaitNs{0};
+  std::atomic<uint64_t> outputWaitNs{0};
+};
+
+std::string jsonString(const std::string& text) {
+  std::string quoted = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if ((unsigned char)c < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      quoted += escaped;
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+std::string boardString(const int board[9][9]) {
+  std::string text(81, '0');
+  for (int cell = 0; cell < 81; ++cell) {
+    text[cell] = (char)('0' + board[cell / 9][cell % 9]);
+  }
+  return text;
+}
+
+void decodeItem(BatchItem& item) {
+  TRACE_SCOPE(STAGE_DECODE);
+  item.image = cv::imread(item.path, cv::IMREAD_COLOR);
+  item.decoded = !item.image.empty();
+}
+
+// Геометрия сетки — глобальные переменные sudokuOcr, поэтому эта стадия
+// однопоточная: она сохраняет снимок геометрии для стадии распознавания
+void locateItem(BatchItem& item, const std::string& layout) {
+  if (!item.decoded) {
+    return;
+  }
+  item.gridFound = calibrateGrid(item.image, layout);
+  item.geometry = currentGridGeometry();
+}
+
+void recognizeItem(BatchItem& item, const std::vector<cv::Mat>& templates) {
+  if (!item.decoded) {
+    return;
+  }
+  BinarizedGrid grid;
+  if (!binarizeGrid(item.image, item.geometry, grid)) {
+    return;
+  }
+  for (int row = 0; row < 9; ++row) {
+    for (int column = 0; column < 9; ++column) {
+      cv::Mat gray, binary;
+      if (!gridCell(grid, row, column, gray, binary)) {
+        return;
+      }
+      item.board.digits[row][column] = recognizeBinarizedCell(
+          gray, binary, templates, item.board.confidence[row][column], item.board.ranked[row][column]);
+    }
+  }
+  item.recognized = true;
+  item.image.release();  // дальше пиксели не нужны, не держим память в очередях
+}
+
+void solveItem(BatchItem& item) {
+  if (!item.recognized) {
+    return;
+  }
+  TRACE_SCOPE(STAGE_SOLVE);
+  resolve_scanned_board(item.board.digits, item.board.confidence, item.board.ranked, item.resolution);
+  item.resolved = true;
+}
+
+std::string resultRecord(const BatchItem& item) {
+  const Resolution& resolution = item.resolution;
+  const char* status = !item.decoded ? "unreadable"
+                       : !item.resolved ? "unrecognized"
+                       : !resolution.solved ? "unsolvable"
+                       : !resolution.unique ? "ambiguous"
+                                            : "solved";
+
+  std::string record = "{\"image\":" + jsonString(item.path) + ",\"status\":\"" + status + "\"";
+  if (item.decoded) {
+    record += std::string(",\"grid_found\":") + (item.gridFound ? "true" : "false");
+  }
+  if (item.recognized) {
+    double minConfidence = 1.0;
+    int lowConfidence = 0;
+    for (int row = 0; row < 9; ++row) {
+      for (int column = 0; column < 9; ++column) {
+        minConfidence = std::min(minConfidence, item.board.confidence[row][column]);
+        lowConfidence += item.board.confidence[row][column] < batch_low_confidence;
+      }
+    }
+    char confidence[96];
+    snprintf(confidence, sizeof(confidence), ",\"min_confidence\":%.3f,\"low_confidence_cells\":%d",
+             minConfidence, lowConfidence);
+    record += ",\"puzzle\":\"" + boardString(item.board.digits) + "\"" + confidence;
+  }
+  if (item.resolved && !resolution.corrections.empty()) {
+    record += ",\"corrected_puzzle\":\"" + boardString(resolution.board) + "\",\"corrections\":[";
+    for (size_t i = 0; i < resolution.corrections.size(); ++i) {
+      const CellCorrection& correction = resolution.corrections[i];
+      char text[128];
+      snprintf(text, sizeof(text), "%s{\"row\":%d,\"col\":%d,\"read\":%d,\"corrected\":%d,\"score\":%.3f}",
+               i > 0 ? "," : "", correction.row, correction.col, correction.read_digit, correction.corrected_digit,
+               correction.corrected_score);
+      record += text;
+    }
+    record += "]";
+  }
+  if (item.resolved && resolution.solved) {
+    record += ",\"solution\":\"" + boardString(resolution.solution) + "\"";
+  }
+
+  char timings[160];
+  snprintf(timings, sizeof(timings), ",\"ms\":{\"decode\":%.2f,\"locate\":%.2f,\"recognize\":%.2f,\"solve\":%.3f}}",
+           item.stageMs[BATCH_DECODE], item.stageMs[BATCH_LOCATE], item.stageMs[BATCH_RECOGNIZE],
+           item.stageMs[BATCH_SOLVE]);
+  return record + timings;
+}
+
+// Общий цикл рабочего потока стадии: взять, обработать, передать дальше
+template <typename Work>
+void runStage(BoundedQueue& input, BoundedQueue& output, StageStats& stats, BatchStage stage, Work work) {
+  ItemPtr item;
+  while (input.pop(item, stats.inputWaitNs)) {
+    uint64_t start = traceNow();
+    work(*item);
+    uint64_t busy = traceNow() - start;
+    item->stageMs[stage] = busy / 1e6;
+    stats.busyNs += busy;
+    ++stats.items;
+    output.push(std::move(item), stats.outputWaitNs);
+  }
+  output.producerDone();
+}
+
+void printStageStats(const StageStats stats[BATCH_STAGES], double wallSeconds) {
+  std::printf("%-10s %8s %8s %12s %12s %9s %9s\n", "stage", "workers", "images", "images/s", "busy s",
+              "starved", "blocked");
+  for (int stage = 0; stage < BATCH_STAGES; ++stage) {
+    const StageStats& s = stats[stage];
+    double busy = s.busyNs / 1e9;
+    // Сколько снимков в секунду стадия выдержала бы сама по себе
+    double capacity = busy > 0 ? s.items * s.workers / busy : 0;
+    double workerSeconds = wallSeconds * s.workers;
+    std::printf("%-10s %8d %8llu %12.1f %12.2f %8.0f%% %8.0f%%\n", BATCH_STAGE_NAMES[stage], s.workers,
+                (unsigned long long)s.items.load(), capacity, busy,
+                workerSeconds > 0 ? 100.0 * s.inputWaitNs / 1e9 / workerSeconds : 0,
+                workerSeconds > 0 ? 100.0 * s.outputWaitNs / 1e9 / workerSeconds : 0);
+  }
+}
+
+}  // namespace
+
+bool collectBatchInputs(const std::string& source, std::vector<std::string>& paths) {
+  namespace fs = std::filesystem;
+  std::error_code error;
+  if (fs::is_directory(source, error)) {
+    for (const fs::directory_entry& entry : fs::directory_iterator(source, error)) {
+      std::string extension = entry.path().extension().string();
+      std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+      if (entry.is_regular_file() && (extension == ".png" || extension == ".jpg" || extension == ".jpeg")) {
+        paths.push_back(entry.path().string());
+      }
+    }
+    std::sort(paths.begin(), paths.end());
+    return true;
+  }
+
+  std::ifstream list(source);
+  if (!list) {
+    std::cerr << "Failed reading batch input " << source << std::endl;
+    return false;
+  }
+  std::string line;
+  while (std::getline(list, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (!line.empty() && line[0] != '#') {
+      paths.push_back(line);
+    }
+  }
+  return true;
+}
+
+int runBatch(const std::vector<std::string>& paths, const std::string& layout, const std::string& outputPath) {
+  std::vector<cv::Mat> templates;
+  if (!loadTemplates(templates)) {
+    return 1;
+  }
+  std::ofstream output(outputPath, std::ios::trunc);
+  if (!output) {
+    std::cerr << "Failed writing " << outputPath << std::endl;
+    return 1;
+  }
+
+  int decodeWorkers = std::max(1, batch_decode_workers);
+  int recognizeWorkers = std::max(1, batch_recognize_workers);
+  int solveWorkers = std::max(1, batch_solve_workers);
+  size_t capacity = std::max(1, batch_queue_capacity);
+
+  // Источник -> decode -> locate -> recognize -> solve -> запись
+  BoundedQueue pending(capacity, 1);
+  BoundedQueue decoded(capacity, decodeWorkers);
+  BoundedQueue located(capacity, 1);
+  BoundedQueue recognized(capacity, recognizeWorkers);
+  BoundedQueue solved(capacity, solveWorkers);
+
+  StageStats stats[BATCH_STAGES];
+  stats[BATCH_DECODE].workers = decodeWorkers;
+  stats[BATCH_RECOGNIZE].workers = recognizeWorkers;
+  stats[BATCH_SOLVE].workers = solveWorkers;
+  std::atomic<uint64_t> sourceWaitNs(0);
+
+  auto started = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+
+  threads.emplace_back([&] {
+    for (size_t i = 0; i < paths.size(); ++i) {
+      ItemPtr item(new BatchItem());
+      item->index = i;
+      item->path = paths[i];
+      pending.push(std::move(item), sourceWaitNs);
+    }
+    pending.producerDone();
+  });
+  for (int i = 0; i < decodeWorkers; ++i) {
+    threads.emplace_back([&] { runStage(pending, decoded, stats[BATCH_DECODE], BATCH_DECODE, decodeItem); });
+  }
+  threads.emplace_back([&] {
+    runStage(decoded, located, stats[BATCH_LOCATE], BATCH_LOCATE,
+             [&](BatchItem& item) { locateItem(item, layout); });
+  });
+  for (int i = 0; i < recognizeWorkers; ++i) {
+    threads.emplace_back([&] {
+      runStage(located, recognized, stats[BATCH_RECOGNIZE], BATCH_RECOGNIZE,
+               [&](BatchItem& item) { recognizeItem(item, templates); });
+    });
+  }
+  for (int i = 0; i < solveWorkers; ++i) {
+    threads.emplace_back([&] {
+      runStage(recognized, solved, stats[BATCH_SOLVE], BATCH_SOLVE, solveItem);
+    });
+  }
+
+  // Записи выходят в порядке входа: обогнавшие ждут в буфере
+  std::map<size_t, ItemPtr> reorder;
+  std::atomic<uint64_t> writerWaitNs(0);
+  size_t nextIndex = 0;
+  size_t solvedCount = 0;
+  ItemPtr item;
+  while (solved.pop(item, writerWaitNs)) {
+    size_t index = item->index;
+    reorder[index] = std::move(item);
+    while (!reorder.empty() && reorder.begin()->first == nextIndex) {
+      TRACE_SCOPE(STAGE_WRITE);
+      const BatchItem& done = *reorder.begin()->second;
+      solvedCount += done.resolved && done.resolution.solved;
+      output << resultRecord(done) << "\n";
+      reorder.erase(reorder.begin());
+      ++nextIndex;
+    }
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  output.flush();
+
+  double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  std::printf("Batch: %zu images, %zu solved in %.2f s (%.1f images/s), results in %s\n", paths.size(),
+              solvedCount, wallSeconds, wallSeconds > 0 ? paths.size() / wallSeconds : 0, outputPath.c_str());
+  printStageStats(stats, wallSeconds);
+  return output ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+// Пакетная обработка скриншотов (matchTemplate --batch): декодирование,
+// поиск сетки, распознавание и решение идут параллельными стадиями,
+// связанными очередями ограниченного размера. На каждый снимок пишется
+// одна строка JSON, в конце — пропускная способность каждой стадии.
+
+#include <string>
+#include <vector>
+
+// Число потоков на стадиях и ёмкость очередей между ними
+extern int batch_decode_workers;
+extern int batch_recognize_workers;
+extern int batch_solve_workers;
+extern int batch_queue_capacity;
+// Ячейки с уверенностью ниже порога считаются сомнительными
+extern double batch_low_confidence;
+
+/**
+ * Expands a directory (its .png/.jpg files, sorted) or a list file (one
+ * path per line) into image paths
+ */
+bool collectBatchInputs(const std::string& source, std::vector<std::string>& paths);
+
+/**
+ * Runs the pipeline over the images and writes one JSON record per image,
+ * in input order, to outputPath
+ * @return 0 on success, 1 if the run could not start
+ */
+int runBatch(const std::vector<std::string>& paths, const std::string& layout, const std::string& outputPath);
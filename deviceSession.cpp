@@ -0,0 +1,299 @@
+#include "deviceSession.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int session_timeout_ms = 10000;
+
+// Файл на устройстве, через который идёт снимок экрана
+static const char *DEVICE_SCREEN_PATH = "/data/local/tmp/sudoku_screen.png";
+
+static std::string default_adb_path()
+{
+  const char *path = std::getenv("ADB");
+  return path && *path ? path : "adb";
+}
+
+DeviceSession::DeviceSession()
+    : DeviceSession(default_adb_path())
+{
+}
+
+DeviceSession::DeviceSession(const std::string &adb_path)
+    : adb_path(adb_path), pid(-1), to_shell(-1), from_shell(-1), marker_count(0)
+{
+}
+
+DeviceSession::~DeviceSession()
+{
+  close();
+}
+
+bool DeviceSession::open()
+{
+  if (is_open())
+  {
+    return true;
+  }
+
+  // Запись в упавший adb не должна убивать весь процесс
+  signal(SIGPIPE, SIG_IGN);
+
+  int input[2], output[2];
+  if (pipe(input) != 0)
+  {
+    return false;
+  }
+  if (pipe(output) != 0)
+  {
+    ::close(input[0]);
+    ::close(input[1]);
+    return false;
+  }
+
+  pid = fork();
+  if (pid < 0)
+  {
+    ::close(input[0]);
+    ::close(input[1]);
+    ::close(output[0]);
+    ::close(output[1]);
+    return false;
+  }
+
+  if (pid == 0)
+  {
+    dup2(input[0], STDIN_FILENO);
+    dup2(output[1], STDOUT_FILENO);
+    ::close(input[0]);
+    ::close(input[1]);
+    ::close(output[0]);
+    ::close(output[1]);
+    execlp(adb_path.c_str(), adb_path.c_str(), "shell", (char *)nullptr);
+    _exit(127);
+  }
+
+  ::close(input[0]);
+  ::close(output[1]);
+  to_shell = input[1];
+  from_shell = output[0];
+  fcntl(to_shell, F_SETFD, FD_CLOEXEC);
+  fcntl(from_shell, F_SETFD, FD_CLOEXEC);
+  buffer.clear();
+
+  // Убеждаемся, что shell действительно отвечает
+  std::string marker = next_marker();
+  std::string ignored;
+  if (!write_all("echo " + marker + "\n") || !read_until_marker(marker, ignored))
+  {
+    std::cerr << "Device session: " << adb_path << " shell is not responding" << std::endl;
+    close();
+    return false;
+  }
+  return true;
+}
+
+void DeviceSession::close()
+{
+  if (!is_open())
+  {
+    return;
+  }
+
+  write_all("exit\n");
+  ::close(to_shell);
+  ::close(from_shell);
+  to_shell = -1;
+  from_shell = -1;
+
+  // Даём adb завершиться самому, зависший — убиваем
+  for (int i = 0; i < 50 && waitpid(pid, nullptr, WNOHANG) == 0; i++)
+  {
+    usleep(10000);
+  }
+  if (waitpid(pid, nullptr, WNOHANG) == 0)
+  {
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+  }
+  pid = -1;
+  buffer.clear();
+}
+
+bool DeviceSession::capture(std::vector<unsigned char> &png)
+{
+  std::string path = DEVICE_SCREEN_PATH;
+  std::string command = "if screencap -p " + path + "; then echo \"SIZE $(stat -c %s " + path +
+                        ")\"; cat " + path + "; else echo 'SIZE -1'; fi\n";
+
+  // Вторая попытка — после переподключения
+  for (int attempt = 0; attempt < 2; attempt++)
+  {
+    if (!open() || !write_all(command))
+    {
+      close();
+      continue;
+    }
+
+    // Пропускаем вывод ранее отправленных команд до строки с размером
+    std::string line;
+    long size = 0;
+    bool found = false;
+    while (!found && read_line(line))
+    {
+      found = sscanf(line.c_str(), "SIZE %ld", &size) == 1;
+    }
+    if (!found)
+    {
+      close();
+      continue;
+    }
+    if (size <= 0)
+    {
+      std::cerr << "Device session: screencap failed" << std::endl;
+      return false;
+    }
+    if (read_bytes(size, png))
+    {
+      return true;
+    }
+    close();
+  }
+  return false;
+}
+
+bool DeviceSession::execute(const std::string &command, std::string &output)
+{
+  // Вторая попытка — после переподключения
+  for (int attempt = 0; attempt < 2; attempt++)
+  {
+    std::string marker = next_marker();
+    output.clear();
+    if (open() && write_all(command + "\necho " + marker + "\n") && read_until_marker(marker, output))
+    {
+      return true;
+    }
+    close();
+  }
+  return false;
+}
+
+bool DeviceSession::send(const std::string &command)
+{
+  for (int attempt = 0; attempt < 2; attempt++)
+  {
+    if (open() && write_all(command + "\n"))
+    {
+      return true;
+    }
+    close();
+  }
+  return false;
+}
+
+bool DeviceSession::flush()
+{
+  std::string ignored;
+  return execute("true", ignored);
+}
+
+bool DeviceSession::write_all(const std::string &data)
+{
+  size_t written = 0;
+  while (written < data.size())
+  {
+    ssize_t result = write(to_shell, data.data() + written, data.size() - written);
+    if (result < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (result <= 0)
+    {
+      return false;
+    }
+    written += result;
+  }
+  return true;
+}
+
+bool DeviceSession::fill_buffer()
+{
+  pollfd descriptor = {from_shell, POLLIN, 0};
+  int ready = poll(&descriptor, 1, session_timeout_ms);
+  if (ready <= 0)
+  {
+    if (ready == 0)
+    {
+      std::cerr << "Device session: timed out waiting for device" << std::endl;
+    }
+    return false;
+  }
+
+  char chunk[1 << 16];
+  ssize_t count = read(from_shell, chunk, sizeof(chunk));
+  if (count <= 0)
+  {
+    return false;
+  }
+  buffer.append(chunk, count);
+  return true;
+}
+
+bool DeviceSession::read_line(std::string &line)
+{
+  size_t end;
+  while ((end = buffer.find('\n')) == std::string::npos)
+  {
+    if (!fill_buffer())
+    {
+      return false;
+    }
+  }
+  line = buffer.substr(0, end);
+  if (!line.empty() && line.back() == '\r')
+  {
+    line.pop_back();
+  }
+  buffer.erase(0, end + 1);
+  return true;
+}
+
+bool DeviceSession::read_bytes(size_t count, std::vector<unsigned char> &data)
+{
+  while (buffer.size() < count)
+  {
+    if (!fill_buffer())
+    {
+      return false;
+    }
+  }
+  data.assign(buffer.begin(), buffer.begin() + count);
+  buffer.erase(0, count);
+  return true;
+}
+
+bool DeviceSession::read_until_marker(const std::string &marker, std::string &output)
+{
+  std::string line;
+  while (read_line(line))
+  {
+    if (line == marker)
+    {
+      return true;
+    }
+    output += line + "\n";
+  }
+  return false;
+}
+
+std::string DeviceSession::next_marker()
+{
+  return "__sudoku_session_" + std::to_string(++marker_count) + "__";
+}
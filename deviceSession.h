@@ -0,0 +1,65 @@
+#pragma once
+
+// Долгоживущая сессия "adb shell": один процесс adb на все снимки экрана
+// и нажатия вместо отдельного adb на каждую операцию. При обрыве сессия
+// переподключается сама.
+//
+// Путь к adb берётся из переменной окружения ADB (по умолчанию "adb"),
+// так что сессию можно проверить без устройства: ADB=./fakeAdb.sh
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "answerEntry.h"
+
+extern int session_timeout_ms;  // сколько ждать ответа устройства
+
+class DeviceSession : public InputSink
+{
+public:
+  DeviceSession();
+  explicit DeviceSession(const std::string &adb_path);
+  ~DeviceSession();
+
+  DeviceSession(const DeviceSession &) = delete;
+  DeviceSession &operator=(const DeviceSession &) = delete;
+
+  bool open();
+  void close();
+  bool is_open() const { return pid > 0; }
+
+  /**
+   * Takes a screenshot on the device and returns the PNG bytes
+   */
+  bool capture(std::vector<unsigned char> &png);
+
+  /**
+   * Runs a shell command and collects its standard output
+   */
+  bool execute(const std::string &command, std::string &output);
+
+  /**
+   * Queues a command without waiting for it (input events)
+   */
+  bool send(const std::string &command) override;
+
+  /**
+   * Waits until the device has executed everything sent so far
+   */
+  bool flush() override;
+
+private:
+  bool write_all(const std::string &data);
+  bool fill_buffer();
+  bool read_line(std::string &line);
+  bool read_bytes(size_t count, std::vector<unsigned char> &data);
+  bool read_until_marker(const std::string &marker, std::string &output);
+  std::string next_marker();
+
+  std::string adb_path;
+  pid_t pid;
+  int to_shell;
+  int from_shell;
+  std::string buffer;  // прочитано из adb, но ещё не разобрано
+  unsigned marker_count;
+};
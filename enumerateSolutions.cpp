@@ -0,0 +1,127 @@
+// Потоковый перебор всех решений недозаполненной доски: по строке из 81
+// цифры на решение, в файл или в канал (| head, | wc -l ...).
+//
+// Сборка:
+//   g++ -O2 -o enumerateSolutions enumerateSolutions.cpp sudokuEngine.cpp solveTrace.cpp
+//
+// Запуск:
+//   ./enumerateSolutions [--limit N] [--skip N] [--random SEED] [--sample N] [--output file] [puzzle]
+//
+// puzzle — 81 символ ('0' или '.' для пустых) или файл в формате sudoku.txt;
+// по умолчанию sudoku.txt. Без --output решения идут в stdout.
+// --random перемешивает порядок перебора, --sample N выдаёт N независимых
+// случайных решений (возможны повторы) и с --skip не сочетается.
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "sudokuEngine.h"
+
+static SolutionEnumerator enumerator;
+// sample() перезагружает перебор и снимает отмену, поэтому Ctrl+C запоминается отдельно
+static volatile std::sig_atomic_t interrupted = 0;
+
+static void onInterrupt(int) {
+  interrupted = 1;
+  enumerator.cancel();
+}
+
+bool loadPuzzle(const std::string& source, int puzzle[9][9]) {
+  // Строка из 81 клетки или файл (9 строк по 9 цифр, как sudoku.txt)
+  if (parse_puzzle(source, puzzle)) {
+    return true;
+  }
+  std::ifstream file(source);
+  std::string text, line;
+  while (std::getline(file, line)) {
+    text += line;
+  }
+  if (!file.eof() || !parse_puzzle(text, puzzle)) {
+    std::cerr << "Failed reading puzzle from " << source << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  long long limit = -1;  // без ограничения
+  long long skip = 0;
+  long long samples = 0;
+  unsigned long long seed = 0;
+  std::string outputPath;
+  std::string source = "sudoku.txt";
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--limit" && i + 1 < argc) {
+      limit = std::atoll(argv[++i]);
+    } else if (arg == "--skip" && i + 1 < argc) {
+      skip = std::atoll(argv[++i]);
+    } else if (arg == "--random" && i + 1 < argc) {
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--sample" && i + 1 < argc) {
+      samples = std::atoll(argv[++i]);
+    } else if (arg == "--output" && i + 1 < argc) {
+      outputPath = argv[++i];
+    } else {
+      source = arg;
+    }
+  }
+
+  if (skip > 0 && samples > 0) {
+    std::cerr << "--skip has no meaning for independent samples" << std::endl;
+    return 1;
+  }
+
+  int puzzle[9][9];
+  if (!loadPuzzle(source, puzzle)) {
+    return 1;
+  }
+
+  FILE* output = stdout;
+  if (!outputPath.empty() && !(output = std::fopen(outputPath.c_str(), "w"))) {
+    std::cerr << "Failed writing " << outputPath << std::endl;
+    return 1;
+  }
+
+  // Закрытый канал (| head) — обычное завершение, а не падение по SIGPIPE
+  std::signal(SIGPIPE, SIG_IGN);
+  std::signal(SIGINT, onInterrupt);
+
+  enumerator.set_random_order(seed);
+  if (!enumerator.load(puzzle)) {
+    std::cerr << "The puzzle has conflicting givens" << std::endl;
+    return 1;
+  }
+  long long skipped = enumerator.skip(skip);
+
+  int solution[9][9];
+  char line[83];
+  line[81] = '\n';
+  line[82] = 0;
+  long long written = 0;
+  if (samples > 0) {
+    limit = limit < 0 ? samples : std::min(limit, samples);
+  }
+  while (!interrupted && (limit < 0 || written < limit) && (samples > 0 ? enumerator.sample(solution) : enumerator.next(solution))) {
+    for (int cell = 0; cell < 81; ++cell) {
+      line[cell] = (char)('0' + solution[cell / 9][cell % 9]);
+    }
+    if (std::fwrite(line, 1, 82, output) != 82) {
+      break;
+    }
+    ++written;
+  }
+  std::fflush(output);
+
+  std::cerr << written << " solutions written (" << skipped << " skipped, " << enumerator.total_nodes() << " nodes"
+            << (interrupted || enumerator.cancelled() ? ", interrupted" : "") << ")" << std::endl;
+  if (output != stdout) {
+    std::fclose(output);
+  }
+  return 0;
+}
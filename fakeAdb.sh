@@ -0,0 +1,50 @@
+#!/bin/sh
+# Подмена adb для проверки без устройства:
+#   ADB=./fakeAdb.sh ./matchTemplate
+#
+# FAKE_ADB_SCREEN — картинка, которую отдаёт screencap (по умолчанию screen.png)
+# FAKE_ADB_SIZE   — ответ wm size (по умолчанию 1080x2400)
+# FAKE_ADB_LOG    — куда записываются команды input (по умолчанию fakeAdb.log)
+#
+# Пути устройства /data/local/tmp/ отображаются во временную папку.
+
+screen=$(realpath "${FAKE_ADB_SCREEN:-screen.png}")
+log=$(realpath "${FAKE_ADB_LOG:-fakeAdb.log}")
+size=${FAKE_ADB_SIZE:-1080x2400}
+
+root=$(mktemp -d)
+trap 'rm -rf "$root"' EXIT
+mkdir -p "$root/bin" "$root/tmp"
+
+cat > "$root/bin/screencap" <<SCRIPT
+#!/bin/sh
+[ "\$1" = "-p" ] && shift
+if [ -n "\$1" ]; then cp "$screen" "\$1"; else cat "$screen"; fi
+SCRIPT
+
+cat > "$root/bin/input" <<SCRIPT
+#!/bin/sh
+echo "input \$*" >> "$log"
+SCRIPT
+
+cat > "$root/bin/wm" <<SCRIPT
+#!/bin/sh
+echo "Physical size: $size"
+SCRIPT
+
+chmod +x "$root/bin/"*
+export PATH="$root/bin:$PATH"
+
+case "$1" in
+  shell)
+    sed -u "s|/data/local/tmp/|$root/tmp/|g" | sh
+    ;;
+  exec-out)
+    shift
+    "$@"
+    ;;
+  *)
+    echo "fakeAdb: unsupported command $*" >&2
+    exit 1
+    ;;
+esac
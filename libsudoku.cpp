@@ -0,0 +1,231 @@
+#include "libsudoku.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include "sudokuEngine.h"
+#include "sudokuHints.h"
+
+/**
+ * Everything a call needs, allocated once with the engine. The Hint keeps
+ * its buffers between calls, so grading stops allocating once warm.
+ */
+struct sudoku_engine
+{
+  std::mutex lock;
+  std::atomic<bool> cancel_pending; // survives between the puzzles of a batch
+  BitmaskSolver solver;
+  HintEngine hints;
+  Hint hint;
+  int puzzle[9][9];
+};
+
+/**
+ * Parses 81 characters into engine->puzzle
+ * @return false on a character that is neither a digit nor '.'
+ */
+static bool parse_puzzle(sudoku_engine *engine, const char *text)
+{
+  for (int cell = 0; cell < 81; cell++)
+  {
+    char c = text[cell];
+    if (c == '.')
+      c = '0';
+    if (c < '0' || c > '9')
+    {
+      return false;
+    }
+    engine->puzzle[cell / 9][cell % 9] = c - '0';
+  }
+  return true;
+}
+
+static void write_solution(const sudoku_engine *engine, char *solution)
+{
+  for (int cell = 0; cell < 81; cell++)
+  {
+    solution[cell] = (char)('0' + engine->solver.board[cell / 9][cell % 9]);
+  }
+}
+
+/**
+ * Loads and counts up to limit solutions; the caller holds the lock
+ */
+static int count_locked(sudoku_engine *engine, const char *puzzle, int limit, int &count)
+{
+  count = 0;
+  if (!parse_puzzle(engine, puzzle) || !engine->solver.load(engine->puzzle))
+  {
+    return SUDOKU_INVALID_PUZZLE;
+  }
+  // load() clears the solver's own flag: a sudoku_engine_cancel that landed
+  // after the call started must survive it
+  if (engine->cancel_pending)
+  {
+    engine->solver.cancel();
+  }
+  count = engine->solver.count_solutions(limit);
+  if (engine->solver.cancelled())
+  {
+    return SUDOKU_CANCELLED;
+  }
+  return count == 0 ? SUDOKU_NO_SOLUTION : SUDOKU_OK;
+}
+
+extern "C" {
+
+int sudoku_abi_version(void)
+{
+  return SUDOKU_ABI_VERSION;
+}
+
+sudoku_engine *sudoku_engine_create(void)
+{
+  sudoku_engine *engine = new (std::nothrow) sudoku_engine();
+  if (engine)
+  {
+    engine->cancel_pending = false;
+  }
+  return engine;
+}
+
+void sudoku_engine_destroy(sudoku_engine *engine)
+{
+  delete engine;
+}
+
+void sudoku_engine_cancel(sudoku_engine *engine)
+{
+  if (engine)
+  {
+    engine->cancel_pending = true;
+    engine->solver.cancel();
+  }
+}
+
+int sudoku_solve(sudoku_engine *engine, const char *puzzle, char *solution)
+{
+  if (!engine || !puzzle || !solution)
+  {
+    return SUDOKU_INVALID_ARGUMENT;
+  }
+  std::lock_guard<std::mutex> guard(engine->lock);
+  engine->cancel_pending = false;
+
+  int count;
+  int status = count_locked(engine, puzzle, 1, count);
+  if (status == SUDOKU_OK)
+  {
+    write_solution(engine, solution);
+  }
+  return status;
+}
+
+int sudoku_count_solutions(sudoku_engine *engine, const char *puzzle, int limit, int *count)
+{
+  if (!engine || !puzzle || !count || limit <= 0)
+  {
+    return SUDOKU_INVALID_ARGUMENT;
+  }
+  std::lock_guard<std::mutex> guard(engine->lock);
+  engine->cancel_pending = false;
+
+  int status = count_locked(engine, puzzle, limit, *count);
+  return status == SUDOKU_NO_SOLUTION ? SUDOKU_OK : status;
+}
+
+int sudoku_grade(sudoku_engine *engine, const char *puzzle, sudoku_grade_info *info)
+{
+  if (!engine || !puzzle || !info)
+  {
+    return SUDOKU_INVALID_ARGUMENT;
+  }
+  std::lock_guard<std::mutex> guard(engine->lock);
+  engine->cancel_pending = false;
+
+  info->level = 0;
+  info->clues = 0;
+  info->logical_steps = 0;
+  int count;
+  int status = count_locked(engine, puzzle, 2, count);
+  bool searched = status != SUDOKU_INVALID_PUZZLE;
+  info->nodes = searched ? engine->solver.nodes() : 0;
+  info->guesses = searched ? engine->solver.guesses() : 0;
+  if (status != SUDOKU_OK)
+  {
+    return status;
+  }
+  if (count > 1)
+  {
+    return SUDOKU_MULTIPLE_SOLUTIONS;
+  }
+
+  for (int cell = 0; cell < 81; cell++)
+  {
+    info->clues += engine->puzzle[cell / 9][cell % 9] != 0;
+  }
+
+  // The level is the hardest technique the hint engine needed on the way
+  info->level = SUDOKU_GRADE_EASY;
+  engine->hints.sync(engine->puzzle);
+  while (engine->hints.next_hint(engine->hint) && engine->hint.technique != Hint::CONTRADICTION)
+  {
+    Hint::Technique technique = engine->hint.technique;
+    if (technique == Hint::POINTING || technique == Hint::CLAIMING)
+      info->level = std::max(info->level, (int)SUDOKU_GRADE_MEDIUM);
+    else if (technique == Hint::NAKED_PAIR || technique == Hint::HIDDEN_PAIR)
+      info->level = std::max(info->level, (int)SUDOKU_GRADE_HARD);
+    engine->hints.apply(engine->hint);
+    info->logical_steps++;
+  }
+
+  const CandidateState &state = engine->hints.state();
+  for (int cell = 0; cell < 81; cell++)
+  {
+    if (state.values[cell] == 0)
+    {
+      info->level = SUDOKU_GRADE_EXPERT;
+      break;
+    }
+  }
+  return SUDOKU_OK;
+}
+
+long sudoku_solve_batch(sudoku_engine *engine, const char *puzzles, size_t count, size_t stride, char *solutions,
+                        int *statuses)
+{
+  if (!engine || (count > 0 && (!puzzles || !solutions)) || stride < 81)
+  {
+    return SUDOKU_INVALID_ARGUMENT;
+  }
+  std::lock_guard<std::mutex> guard(engine->lock);
+  engine->cancel_pending = false;
+
+  long solved = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    int found;
+    int status = engine->cancel_pending ? (int)SUDOKU_CANCELLED : count_locked(engine, puzzles + i * stride, 1, found);
+    if (status == SUDOKU_OK)
+    {
+      write_solution(engine, solutions + i * stride);
+      solved++;
+    }
+    if (statuses)
+    {
+      statuses[i] = status;
+    }
+    if (status == SUDOKU_CANCELLED)
+    {
+      // The rest of the batch is cancelled too
+      for (size_t rest = i + 1; statuses && rest < count; rest++)
+      {
+        statuses[rest] = SUDOKU_CANCELLED;
+      }
+      break;
+    }
+  }
+  return solved;
+}
+
+} // extern "C"
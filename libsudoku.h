@@ -0,0 +1,99 @@
+#ifndef LIBSUDOKU_H
+#define LIBSUDOKU_H
+
+/*
+ * libsudoku: C interface to the solver for other services.
+ *
+ * Puzzles and solutions are 81 characters in row order, '1'-'9' for digits
+ * and '0' or '.' for empty cells; no terminating zero is needed or written.
+ * Calls only use the caller's buffers and the engine's preallocated state,
+ * nothing is allocated after sudoku_engine_create().
+ *
+ * An engine may be shared between threads: calls on one engine are
+ * serialized, calls on different engines run in parallel. Keeping one engine
+ * per worker thread avoids the contention.
+ *
+ * Build (shared and static, only sudoku_* symbols exported):
+ *   g++ -O2 -fPIC -fvisibility=hidden -c libsudoku.cpp sudokuEngine.cpp sudokuHints.cpp solveTrace.cpp
+ *   g++ -shared -Wl,-soname,libsudoku.so.1 -o libsudoku.so.1 libsudoku.o sudokuEngine.o sudokuHints.o solveTrace.o
+ *   ar rcs libsudoku.a libsudoku.o sudokuEngine.o sudokuHints.o solveTrace.o
+ * C programs linking the static library also need -lstdc++.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define SUDOKU_API __attribute__((visibility("default")))
+#else
+#define SUDOKU_API
+#endif
+
+/* Bumped on incompatible changes to the functions or structs below */
+#define SUDOKU_ABI_VERSION 1
+
+enum sudoku_status
+{
+  SUDOKU_OK = 0,
+  SUDOKU_NO_SOLUTION = 1,
+  SUDOKU_MULTIPLE_SOLUTIONS = 2, /* sudoku_grade only: the puzzle is not proper */
+  SUDOKU_CANCELLED = 3,
+  SUDOKU_INVALID_PUZZLE = -1,    /* bad characters or conflicting givens */
+  SUDOKU_INVALID_ARGUMENT = -2
+};
+
+enum sudoku_grade_level
+{
+  SUDOKU_GRADE_EASY = 1,   /* singles only */
+  SUDOKU_GRADE_MEDIUM = 2, /* needs pointing or claiming */
+  SUDOKU_GRADE_HARD = 3,   /* needs naked or hidden pairs */
+  SUDOKU_GRADE_EXPERT = 4  /* needs search */
+};
+
+typedef struct sudoku_grade_info
+{
+  int level;          /* sudoku_grade_level */
+  int clues;
+  int logical_steps;  /* hints applied before solving or getting stuck */
+  long long nodes;    /* search nodes to prove the solution unique */
+  long long guesses;  /* branches with more than one candidate in that search */
+} sudoku_grade_info;
+
+typedef struct sudoku_engine sudoku_engine;
+
+SUDOKU_API int sudoku_abi_version(void);
+
+/* NULL if out of memory */
+SUDOKU_API sudoku_engine *sudoku_engine_create(void);
+SUDOKU_API void sudoku_engine_destroy(sudoku_engine *engine);
+
+/* Makes the call currently running on the engine return SUDOKU_CANCELLED; any thread */
+SUDOKU_API void sudoku_engine_cancel(sudoku_engine *engine);
+
+/* Writes the first solution found into solution (may alias puzzle) */
+SUDOKU_API int sudoku_solve(sudoku_engine *engine, const char *puzzle, char *solution);
+
+/* Counts solutions up to limit; *count is 0 for an unsolvable puzzle */
+SUDOKU_API int sudoku_count_solutions(sudoku_engine *engine, const char *puzzle, int limit, int *count);
+
+/* Grades a puzzle with a unique solution by the techniques a player needs */
+SUDOKU_API int sudoku_grade(sudoku_engine *engine, const char *puzzle, sudoku_grade_info *info);
+
+/*
+ * Solves count puzzles stored stride bytes apart (stride >= 81, e.g. 82 for
+ * newline-separated lines). Solutions go to the same offsets in solutions;
+ * bytes past the first 81 of each record are left untouched, so solving a
+ * copy of the input in place keeps its line breaks. statuses may be NULL.
+ * Returns the number of puzzles solved, or SUDOKU_INVALID_ARGUMENT.
+ */
+SUDOKU_API long sudoku_solve_batch(sudoku_engine *engine, const char *puzzles, size_t count, size_t stride,
+                                   char *solutions, int *statuses);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBSUDOKU_H */
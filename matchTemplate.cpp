@@ -1,61 +1,110 @@
 #include <iostream>
 #include <cstdlib>
+#include <algorithm>
 #include <opencv2/opencv.hpp>
 #include <fstream>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include "sudokuOcr.h"
+#include "deviceSession.h"
+#include "pipelineTrace.h"
+#include "batchScan.h"
 
-int getOffset(int index, int cell_size, int thick, int thin, int margin) {
-    int thick_count = index / 3;
-    int thin_count = index - thick_count;
-    return thick + margin + index * cell_size + thick_count * thick + thin_count * thin;
+// Режим слежения (--watch)
+int watch_interval_ms = 100;           // пауза между кадрами
+double cell_change_threshold = 6.0;    // средняя разница пикселей, при которой ячейка считается изменённой
+
+// Трассировка (--trace <file.json>): сохраняется при выходе и по SIGUSR1 в режиме слежения
+std::string trace_path;
+
+// Снимает экран через постоянную сессию adb прямо в память, без промежуточного файла
+bool captureScreen(DeviceSession& device, cv::Mat& image) {
+  std::vector<uchar> buffer;
+  {
+    TRACE_SCOPE(STAGE_CAPTURE);
+    if (!device.capture(buffer)) {
+      return false;
+    }
+  }
+
+  TRACE_SCOPE(STAGE_DECODE);
+  image = cv::imdecode(buffer, cv::IMREAD_COLOR);
+  return !image.empty();
 }
 
-int cell_size = 113;
-int thick = 5;
-int thin = 3;
-int margin_left = 13;
-// int margin_top = 555; для одиночки
-int margin_top = 567; // для мультиплеера 
+bool writeSudoku(const int sudoku[9][9], const std::string& path = "./sudoku.txt") {
+  TRACE_SCOPE(STAGE_WRITE);
+  std::ofstream file(path, std::ios::trunc);
+  if (!file) {
+    std::cerr << "Failed writing " << path << std::endl;
+    return false;
+  }
+
+  for (int row = 0; row < 9; ++row) {
+    for (int column = 0; column < 9; ++column) {
+      file << sudoku[row][column];
+    }
+    file << "\n";
+  }
+  return true;
+}
 
-int main() {
+int scanOnce(const std::string& layout) {
   std::string sudokuGridRawPath = "./sudoku_grid_raw/";
   std::string sudokuGridProcessedPath = "./sudoku_grid/";
   std::string screenRawPath = "screen.png";
   
-  std::string inputPath = screenRawPath;
-  
   std::cout << "Making screenshot..." << std::endl;
-  std::string adbCommand = "adb exec-out screencap -p > " + screenRawPath;
-  int adbResult = std::system(adbCommand.c_str());
-  if (adbResult != 0) {
-    std::cerr << "Failed executing adb command" << std::endl;
+  DeviceSession device;
+  std::vector<uchar> png;
+  bool captured;
+  {
+    TRACE_SCOPE(STAGE_CAPTURE);
+    captured = device.capture(png);
+  }
+  if (!captured) {
+    std::cerr << "Failed capturing screen" << std::endl;
     return 1;
   }
+
+  std::ofstream screenFile(screenRawPath, std::ios::binary | std::ios::trunc);
+  screenFile.write(reinterpret_cast<const char*>(png.data()), png.size());
+  screenFile.close();
   
-  cv::Mat image = cv::imread(inputPath, cv::IMREAD_COLOR);
+  cv::Mat image;
+  {
+    TRACE_SCOPE(STAGE_DECODE);
+    image = cv::imdecode(png, cv::IMREAD_COLOR);
+  }
   if (image.empty()) {
-    std::cerr << "Failed loading image " << inputPath << std::endl; 
+    std::cerr << "Failed decoding screenshot" << std::endl;
     return 1;
   }
+
+  if (!calibrateGrid(image, layout)) {
+    std::cerr << "Grid not found, falling back to default geometry" << std::endl;
+  }
   
   for (int row = 0; row < 9; ++row) {
     for (int column = 0; column < 9; ++column) {
       std::string fileName = "" + std::to_string(row) + '_' + std::to_string(column) + ".png";
       std::string outputPath = sudokuGridRawPath + fileName;
-          
-    int x = getOffset(column, cell_size, thick, thin, margin_left);
-    int y = getOffset(row, cell_size, thick, thin, margin_top);
 
-      cv::Rect roi(x, y, cell_size, cell_size);
-    
-      roi.width = std::min(roi.width, image.cols - roi.x);
-      roi.height = std::min(roi.height, image.rows - roi.y);
+      cv::Mat croppedImage;
+      {
+        TRACE_SCOPE(STAGE_CROP);
+        cv::Rect roi = cellRect(row, column, image);
 
-      if (roi.width <= 0 || roi.height <= 0) {
-          std::cerr << "Некорректная область обрезки (ROI)!" << std::endl;
-          return 1;
-      }
+        if (roi.width <= 0 || roi.height <= 0) {
+            std::cerr << "Некорректная область обрезки (ROI)!" << std::endl;
+            return 1;
+        }
 
-      cv::Mat croppedImage = image(roi);
+        croppedImage = image(roi);
+      }
 
       std::cout << "Saving croped image to " << outputPath << std::endl;
       if (!cv::imwrite(outputPath, croppedImage)) {
@@ -70,67 +119,58 @@ int main() {
   
   //=========================================================================================
 
+  bool emptyCells[9][9] = {};  // заполняется при бинаризации
+  cv::Mat binaryCells[9][9];   // окна в бинаризованной сетке, без копий
+
+  // Одна бинаризация на всю сетку вместо отдельной для каждой ячейки
+  BinarizedGrid grid;
+  if (!binarizeGrid(image, currentGridGeometry(), grid)) {
+    std::cerr << "Некорректная область обрезки (ROI)!" << std::endl;
+    return 1;
+  }
+
   for (int row = 0; row < 9; ++row) {
     for (int column = 0; column < 9; ++column) {
       std::string filename = "" + std::to_string(row) + "_" + std::to_string(column) + ".png";
-      std::string inputPath = sudokuGridRawPath + filename;
       std::string outputPath = sudokuGridProcessedPath + filename;
 
-      cv::Mat img = cv::imread(inputPath, cv::IMREAD_COLOR);
-      if (img.empty()) {
-        std::cerr << "Failed loading image: " << inputPath << std::endl;
-        continue;
-      }
-
       cv::Mat gray;
-      cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
-
-      cv::Mat binary;
-      cv::threshold(gray, binary, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+      if (!gridCell(grid, row, column, gray, binaryCells[row][column])) {
+        std::cerr << "Некорректная область обрезки (ROI)!" << std::endl;
+        return 1;
+      }
+      {
+        TRACE_SCOPE(STAGE_THRESHOLD);
+        emptyCells[row][column] = isEmptyCell(gray, binaryCells[row][column]);
+      }
 
-      cv::imwrite(outputPath, binary);
+      cv::imwrite(outputPath, binaryCells[row][column]);
       std::cout << "Сохранено: " << outputPath << std::endl;
       }
     }
 
-    std::vector<cv::Mat> templates(10);
-    for (int i = 0; i <= 9; ++i) {
-      templates[i] = cv::imread("templates_processed/" + std::to_string(i) + ".png", cv::IMREAD_GRAYSCALE);
+    std::vector<cv::Mat> templates;
+    if (!loadTemplates(templates)) {
+      return 1;
     }
 
     int sudoku[9][9];  // 2D массив для хранения результата
+    int skippedCells = 0;
 
     for (int row = 0; row < 9; ++row) {
       for (int column = 0; column < 9; ++column) {
-        std::string cellPath = sudokuGridProcessedPath + std::to_string(row) + "_" + std::to_string(column) + ".png";
-        cv::Mat cell = cv::imread(cellPath, cv::IMREAD_GRAYSCALE);
-
-        if (cell.empty()) {
-          std::cerr << "Не удалось загрузить ячейку: " << cellPath << std::endl;
-          sudoku[row][column] = 0;  // если ошибка — пусть будет 0
+        if (emptyCells[row][column]) {
+          sudoku[row][column] = 0;
+          ++skippedCells;
+          std::cout << "cell " << row << "," << column << " => 0 (empty, skipped)" << std::endl;
           continue;
         }
 
-        int bestDigit = 0;
-        double bestScore = -1;
-
-        for (int i = 1; i <= 9; ++i) {
-          cv::Mat result;
-          cv::matchTemplate(cell, templates[i], result, cv::TM_CCOEFF_NORMED);
-          double minVal, maxVal;
-          cv::minMaxLoc(result, &minVal, &maxVal);
-
-          if (maxVal > bestScore) {
-            bestScore = maxVal;
-            bestDigit = i;
-          }
-        }
-
-        // Порог уверенности — цифра только если уверенность высокая
-        if (bestScore > 0.9) {
-          sudoku[row][column] = bestDigit;
-        } else {
-          sudoku[row][column] = 0;
+        const cv::Mat& cell = binaryCells[row][column];
+        double bestScore;
+        {
+          TRACE_SCOPE(STAGE_MATCH);
+          sudoku[row][column] = matchDigit(cell, templates, bestScore);
         }
 
         std::cout << "cell " << row << "," << column << " => " << sudoku[row][column]
@@ -138,16 +178,187 @@ int main() {
       }
     }
 
-    std::fstream file("./sudoku.txt");
+    std::cout << "Empty cells skipped: " << skippedCells << " of 81" << std::endl;
+
+    return writeSudoku(sudoku) ? 0 : 1;
+}
+
+// Следит за экраном: сравнивает каждую ячейку с прошлым кадром и
+// распознаёт заново только те, что изменились. Только при изменении доски
+// она проверяется и решается (resolve_scanned_board исправляет сомнительные
+// ячейки), sudoku.txt и sudoku_solution.txt перезаписываются.
+int watch(const std::string& layout) {
+  std::vector<cv::Mat> templates;
+  if (!loadTemplates(templates)) {
+    return 1;
+  }
+
+  DeviceSession device;  // одна сессия adb на всё время слежения
+  int sudoku[9][9] = {};
+  // Оценки и варианты держатся между кадрами: неизменившиеся ячейки не распознаются заново
+  double confidence[9][9];
+  DigitGuess ranked[9][9][OCR_TOP_K];
+  for (int cell = 0; cell < 81; ++cell) {
+    confidence[cell / 9][cell % 9] = 1.0;
+    for (int k = 0; k < OCR_TOP_K; ++k) {
+      ranked[cell / 9][cell % 9][k] = {0, k == 0 ? 1.0 : 0.0};
+    }
+  }
+  cv::Mat previousCells[9][9];
+  cv::Size frameSize;
+
+  std::cout << "Watching screen, press Ctrl+C to stop..." << std::endl;
+  if (trace_enabled) {
+    traceInstallDumpSignal();
+    std::cout << "Send SIGUSR1 to save the trace to " << trace_path << std::endl;
+  }
+
+  while (true) {
+    if (traceDumpRequested()) {
+      traceDump(trace_path);
+    }
+
+    auto frameStart = std::chrono::steady_clock::now();
+
+    cv::Mat image;
+    if (!captureScreen(device, image)) {
+      std::cerr << "Failed capturing screen, retrying..." << std::endl;
+      std::this_thread::sleep_for(std::chrono::milliseconds(500));
+      continue;
+    }
+
+    // Новое разрешение — пересчитываем сетку и распознаём всё заново
+    if (image.size() != frameSize) {
+      frameSize = image.size();
+      if (!calibrateGrid(image, layout)) {
+        std::cerr << "Grid not found, falling back to default geometry" << std::endl;
+      }
+      for (int row = 0; row < 9; ++row) {
+        for (int column = 0; column < 9; ++column) {
+          previousCells[row][column].release();
+        }
+      }
+    }
+
+    int changedCells = 0;
+    bool boardChanged = false;
+    BinarizedGrid grid;  // бинаризуется один раз за кадр, при первой изменившейся ячейке
+    bool binarized = false;
 
     for (int row = 0; row < 9; ++row) {
       for (int column = 0; column < 9; ++column) {
-        file << sudoku[row][column];
+        cv::Mat cell;
+        {
+          TRACE_SCOPE(STAGE_CROP);
+          cv::Rect roi = cellRect(row, column, image);
+          if (roi.width <= 0 || roi.height <= 0) {
+            std::cerr << "Некорректная область обрезки (ROI)!" << std::endl;
+            return 1;
+          }
+          cell = image(roi);
+        }
+
+        cv::Mat& previous = previousCells[row][column];
+        if (!previous.empty() && previous.size() == cell.size()) {
+          cv::Mat diff;
+          cv::absdiff(cell, previous, diff);
+          cv::Scalar meanDiff = cv::mean(diff);
+          if ((meanDiff[0] + meanDiff[1] + meanDiff[2]) / 3 < cell_change_threshold) {
+            continue;
+          }
+        }
+        cell.copyTo(previous);
+        ++changedCells;
+
+        if (!binarized && !(binarized = binarizeGrid(image, currentGridGeometry(), grid))) {
+          std::cerr << "Некорректная область обрезки (ROI)!" << std::endl;
+          return 1;
+        }
+        cv::Mat gray, binary;
+        gridCell(grid, row, column, gray, binary);
+        int digit = recognizeBinarizedCell(gray, binary, templates, confidence[row][column], ranked[row][column]);
+
+        if (digit != sudoku[row][column]) {
+          sudoku[row][column] = digit;
+          boardChanged = true;
+          std::cout << "cell " << row << "," << column << " => " << digit << std::endl;
+        }
+      }
+    }
+
+    if (boardChanged) {
+      Resolution resolution;
+      {
+        TRACE_SCOPE(STAGE_SOLVE);
+        resolve_scanned_board(sudoku, confidence, ranked, resolution);
+      }
+      for (const CellCorrection& correction : resolution.corrections) {
+        std::cout << "cell " << correction.row << "," << correction.col << " corrected " << correction.read_digit
+                  << " -> " << correction.corrected_digit << std::endl;
+      }
+      writeSudoku(resolution.board);
+      if (resolution.solved) {
+        std::cout << (resolution.unique ? "Solved:" : "Solved (not unique):") << std::endl;
+        for (int row = 0; row < 9; ++row) {
+          for (int column = 0; column < 9; ++column) {
+            std::cout << resolution.solution[row][column];
+          }
+          std::cout << std::endl;
+        }
+        writeSudoku(resolution.solution, "./sudoku_solution.txt");
+      } else {
+        std::cout << "Board has no solution as read" << std::endl;
       }
-      file << "\n";
     }
 
-    file.close();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - frameStart);
+    if (changedCells > 0) {
+      std::cout << "Frame: " << changedCells << " cells re-recognized in "
+                << elapsed.count() << " ms" << std::endl;
+    }
+    if (elapsed.count() < watch_interval_ms) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(watch_interval_ms) - elapsed);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  // Раскладка экрана (например, single или multiplayer) — часть ключа кэша калибровки
+  std::string layout = "default";
+  bool watchMode = false;
+  std::string batchSource;                          // --batch <папка | список файлов>
+  std::string batchOutput = "batch_results.jsonl";  // --output <file>
 
-    return 0;
-}
\ No newline at end of file
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--watch") {
+      watchMode = true;
+    } else if (arg == "--templates" && i + 1 < argc) {
+      template_key = argv[++i];
+    } else if (arg == "--batch" && i + 1 < argc) {
+      batchSource = argv[++i];
+    } else if (arg == "--output" && i + 1 < argc) {
+      batchOutput = argv[++i];
+    } else if (arg == "--workers" && i + 1 < argc) {
+      batch_decode_workers = batch_recognize_workers = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--trace" && i + 1 < argc) {
+      trace_path = argv[++i];
+      trace_enabled = true;
+    } else {
+      layout = arg;
+    }
+  }
+
+  int result;
+  if (!batchSource.empty()) {
+    std::vector<std::string> paths;
+    result = collectBatchInputs(batchSource, paths) ? runBatch(paths, layout, batchOutput) : 1;
+  } else {
+    result = watchMode ? watch(layout) : scanOnce(layout);
+  }
+  if (trace_enabled) {
+    traceDump(trace_path);
+  }
+  return result;
+}
@@ -0,0 +1,295 @@
+// Бенчмарк распознавания на размеченных фикстурах: точность и скорость
+// каждой стадии (нарезка, бинаризация, сопоставление).
+//
+// Сборка:
+//   g++ -O2 -o ocrBench ocrBench.cpp sudokuOcr.cpp pipelineTrace.cpp `pkg-config --cflags --libs opencv4`
+//
+// Запуск:
+//   ./ocrBench [--iterations N] [--layout name] [<labels.txt> <cells_dir/ | screenshot.png>]...
+//
+// Фикстура — пара: файл с ответом (9 строк по 9 цифр, как sudoku.txt) и либо
+// папка с нарезанными ячейками <row>_<col>.png, либо целый скриншот.
+// Без аргументов проверяются фикстуры из ocr_fixtures/ — туда не пишет ни
+// один инструмент (matchTemplate перезаписывает sudoku.txt и sudoku_grid_raw/
+// в корне): ocr_fixtures/sudoku.txt на ocr_fixtures/grid_cells/ и на
+// ocr_fixtures/synthetic_screenshot.png — экране 1080x2400, собранном из тех же
+// ячеек по геометрии по умолчанию, чтобы прогонялись поиск сетки и
+// бинаризация всей сетки. Настоящего снимка с устройства среди фикстур пока
+// нет; его стоит положить туда же парой <name>.png + <name>.txt и
+// передать аргументами.
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "sudokuOcr.h"
+
+struct Fixture {
+  std::string labelsPath;
+  std::string sourcePath;
+  int labels[9][9];
+  cv::Mat screenshot;   // пустой, если фикстура — папка с ячейками
+  GridGeometry geometry; // сетка на скриншоте по его собственной калибровке
+  cv::Mat cells[9][9];  // уже нарезанные ячейки (для папки)
+};
+
+struct Stage {
+  std::string name;
+  std::vector<double> latencies;  // мкс на ячейку
+};
+
+struct CellResult {
+  std::string fixture;
+  int row, column;
+  int label, predicted;
+  bool skipped;
+  double score;
+};
+
+bool loadLabels(const std::string& path, int labels[9][9]) {
+  std::ifstream file(path);
+  for (int row = 0; row < 9; ++row) {
+    std::string line;
+    if (!std::getline(file, line) || line.size() < 9) {
+      std::cerr << "Failed reading labels line " << row + 1 << " of " << path << std::endl;
+      return false;
+    }
+    for (int column = 0; column < 9; ++column) {
+      if (line[column] < '0' || line[column] > '9') {
+        std::cerr << "Bad label '" << line[column] << "' in " << path << std::endl;
+        return false;
+      }
+      labels[row][column] = line[column] - '0';
+    }
+  }
+  return true;
+}
+
+bool loadFixture(Fixture& fixture, const std::string& layout) {
+  if (!loadLabels(fixture.labelsPath, fixture.labels)) {
+    return false;
+  }
+
+  const std::string& source = fixture.sourcePath;
+  if (source.size() > 4 && source.compare(source.size() - 4, 4, ".png") == 0) {
+    fixture.screenshot = cv::imread(source, cv::IMREAD_COLOR);
+    if (fixture.screenshot.empty()) {
+      std::cerr << "Failed loading image " << source << std::endl;
+      return false;
+    }
+    if (!calibrateGrid(fixture.screenshot, layout)) {
+      std::cerr << "Grid not found on " << source << ", using default geometry" << std::endl;
+    }
+    fixture.geometry = currentGridGeometry();
+    return true;
+  }
+
+  std::string folder = source.back() == '/' ? source : source + "/";
+  for (int row = 0; row < 9; ++row) {
+    for (int column = 0; column < 9; ++column) {
+      std::string path = folder + std::to_string(row) + "_" + std::to_string(column) + ".png";
+      fixture.cells[row][column] = cv::imread(path, cv::IMREAD_COLOR);
+      if (fixture.cells[row][column].empty()) {
+        std::cerr << "Failed loading image: " << path << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+double elapsedMicros(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+double percentile(std::vector<double> values, double fraction) {
+  if (values.empty()) {
+    return 0;
+  }
+  size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+void printStage(const Stage& stage) {
+  double total = 0;
+  for (double latency : stage.latencies) {
+    total += latency;
+  }
+  double cellsPerSecond = total > 0 ? stage.latencies.size() / (total / 1e6) : 0;
+
+  std::cout << std::left << std::setw(10) << stage.name << std::right
+            << std::setw(10) << stage.latencies.size()
+            << std::setw(14) << std::fixed << std::setprecision(0) << cellsPerSecond
+            << std::setw(10) << std::setprecision(1) << percentile(stage.latencies, 0.5)
+            << std::setw(10) << percentile(stage.latencies, 0.9)
+            << std::setw(10) << percentile(stage.latencies, 0.99) << std::endl;
+}
+
+int main(int argc, char** argv) {
+  int iterations = 20;
+  std::string layout = "default";
+  std::vector<Fixture> fixtures;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--iterations" && i + 1 < argc) {
+      iterations = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--layout" && i + 1 < argc) {
+      layout = argv[++i];
+    } else if (i + 1 < argc) {
+      Fixture fixture;
+      fixture.labelsPath = arg;
+      fixture.sourcePath = argv[++i];
+      fixtures.push_back(fixture);
+    } else {
+      std::cerr << "Missing source for labels " << arg << std::endl;
+      return 1;
+    }
+  }
+  if (fixtures.empty()) {
+    for (const char* source : {"ocr_fixtures/grid_cells/", "ocr_fixtures/synthetic_screenshot.png"}) {
+      Fixture fixture;
+      fixture.labelsPath = "ocr_fixtures/sudoku.txt";
+      fixture.sourcePath = source;
+      fixtures.push_back(fixture);
+    }
+  }
+
+  for (Fixture& fixture : fixtures) {
+    if (!loadFixture(fixture, layout)) {
+      return 1;
+    }
+  }
+
+  std::vector<cv::Mat> templates;
+  if (!loadTemplates(templates)) {
+    return 1;
+  }
+
+  Stage crop = {"crop", {}};
+  Stage threshold = {"threshold", {}};
+  Stage match = {"match", {}};
+  std::vector<CellResult> results;
+
+  for (int iteration = 0; iteration < iterations; ++iteration) {
+    for (Fixture& fixture : fixtures) {
+      // Скриншот бинаризуется целиком, его время делится поровну на 81 ячейку
+      BinarizedGrid grid;
+      double gridShare = 0;
+      if (!fixture.screenshot.empty()) {
+        auto start = std::chrono::steady_clock::now();
+        if (!binarizeGrid(fixture.screenshot, fixture.geometry, grid)) {
+          std::cerr << "Grid does not fit on " << fixture.sourcePath << std::endl;
+          return 1;
+        }
+        gridShare = elapsedMicros(start) / 81;
+      }
+
+      for (int row = 0; row < 9; ++row) {
+        for (int column = 0; column < 9; ++column) {
+          cv::Mat gray, binary;
+          if (!fixture.screenshot.empty()) {
+            auto start = std::chrono::steady_clock::now();
+            gridCell(grid, row, column, gray, binary);
+            crop.latencies.push_back(elapsedMicros(start));
+          }
+
+          auto start = std::chrono::steady_clock::now();
+          if (fixture.screenshot.empty()) {
+            binarizeCell(fixture.cells[row][column], gray, binary);
+          }
+          bool skipped = isEmptyCell(gray, binary);
+          threshold.latencies.push_back(gridShare + elapsedMicros(start));
+
+          int predicted = 0;
+          double score = -1;
+          if (!skipped) {
+            start = std::chrono::steady_clock::now();
+            predicted = matchDigit(binary, templates, score);
+            match.latencies.push_back(elapsedMicros(start));
+          }
+
+          // Результат распознавания детерминирован — достаточно первого прохода
+          if (iteration == 0) {
+            results.push_back({fixture.sourcePath, row, column, fixture.labels[row][column],
+                               predicted, skipped, score});
+          }
+        }
+      }
+    }
+  }
+
+  // Матрица ошибок: строки — правильная цифра, столбцы — распознанная
+  int confusion[10][10] = {};
+  int correct = 0;
+  for (const CellResult& result : results) {
+    ++confusion[result.label][result.predicted];
+    if (result.label == result.predicted) {
+      ++correct;
+    }
+  }
+
+  std::cout << "Confusion (rows: expected, columns: recognized)" << std::endl << "     ";
+  for (int predicted = 0; predicted <= 9; ++predicted) {
+    std::cout << std::setw(5) << predicted;
+  }
+  std::cout << std::setw(9) << "recall" << std::endl;
+  for (int label = 0; label <= 9; ++label) {
+    int total = 0;
+    std::cout << std::setw(5) << label;
+    for (int predicted = 0; predicted <= 9; ++predicted) {
+      std::cout << std::setw(5) << confusion[label][predicted];
+      total += confusion[label][predicted];
+    }
+    if (total > 0) {
+      std::cout << std::setw(8) << std::fixed << std::setprecision(1)
+                << 100.0 * confusion[label][label] / total << "%";
+    }
+    std::cout << std::endl;
+  }
+  std::cout << "Accuracy: " << correct << "/" << results.size() << " ("
+            << std::setprecision(2) << 100.0 * correct / results.size() << "%)" << std::endl;
+
+  // Запас до порога: насколько оценка далека от match_threshold в правильную сторону.
+  // Пустые ячейки, отсеянные до сопоставления, оценки не имеют.
+  std::vector<std::pair<double, const CellResult*>> margins;
+  for (const CellResult& result : results) {
+    if (!result.skipped) {
+      double margin = result.label != 0 ? result.score - match_threshold : match_threshold - result.score;
+      margins.push_back({margin, &result});
+    }
+  }
+  std::sort(margins.begin(), margins.end(),
+            [](const std::pair<double, const CellResult*>& a, const std::pair<double, const CellResult*>& b) {
+              return a.first < b.first;
+            });
+
+  int skippedCells = results.size() - margins.size();
+  std::cout << std::endl << "Margin to threshold " << match_threshold << " (" << skippedCells
+            << " empty cells skipped before matching), smallest:" << std::endl;
+  for (size_t i = 0; i < margins.size() && i < 10; ++i) {
+    const CellResult& result = *margins[i].second;
+    std::cout << "  " << result.fixture << " " << result.row << "," << result.column
+              << " expected " << result.label << " got " << result.predicted
+              << " score " << std::setprecision(3) << result.score
+              << " margin " << std::showpos << margins[i].first << std::noshowpos << std::endl;
+  }
+
+  std::cout << std::endl << "Timing over " << iterations << " iterations, latency in us per cell" << std::endl;
+  std::cout << std::left << std::setw(10) << "stage" << std::right << std::setw(10) << "cells"
+            << std::setw(14) << "cells/sec" << std::setw(10) << "p50"
+            << std::setw(10) << "p90" << std::setw(10) << "p99" << std::endl;
+  if (!crop.latencies.empty()) {
+    printStage(crop);
+  }
+  printStage(threshold);
+  printStage(match);
+
+  return correct == static_cast<int>(results.size()) ? 0 : 2;
+}
@@ -0,0 +1,191 @@
+#include "ocrResolve.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include "sudokuEngine.h"
+
+double resolve_low_confidence = 0.95;
+int resolve_max_cells = 8;
+int resolve_max_attempts = 5000;
+
+// Scores are clamped so a zero score does not rule a digit out completely
+static double log_score(double score)
+{
+  return std::log(std::max(score, 0.01));
+}
+
+struct SuspectCell
+{
+  int cell;
+  double confidence;
+  std::vector<DigitGuess> options; // options[0] is the digit as read
+};
+
+/**
+ * Cells whose given digit repeats in a row, column or box
+ */
+static void find_conflicts(const int digits[9][9], bool conflict[81])
+{
+  std::fill(conflict, conflict + 81, false);
+  for (int a = 0; a < 81; a++)
+  {
+    int digit = digits[a / 9][a % 9];
+    if (digit == 0)
+    {
+      continue;
+    }
+    for (int b = a + 1; b < 81; b++)
+    {
+      bool same_row = a / 9 == b / 9;
+      bool same_col = a % 9 == b % 9;
+      bool same_box = a / 27 == b / 27 && a % 9 / 3 == b % 9 / 3;
+      if (digits[b / 9][b % 9] == digit && (same_row || same_col || same_box))
+      {
+        conflict[a] = conflict[b] = true;
+      }
+    }
+  }
+}
+
+static int count_for(BitmaskSolver &solver, const int board[9][9], Resolution &result)
+{
+  result.attempts++;
+  return solver.load(board) ? solver.count_solutions(2) : 0;
+}
+
+void resolve_scanned_board(const int digits[9][9], const double confidence[9][9],
+                           const DigitGuess ranked[9][9][OCR_TOP_K], Resolution &result)
+{
+  BitmaskSolver solver;
+  result.corrections.clear();
+  result.attempts = 0;
+  result.solved = false;
+  result.unique = false;
+  std::copy(&digits[0][0], &digits[0][0] + 81, &result.board[0][0]);
+
+  int as_read = count_for(solver, digits, result);
+  if (as_read >= 1)
+  {
+    result.solved = true;
+    result.unique = as_read == 1;
+    std::copy(&solver.board[0][0], &solver.board[0][0] + 81, &result.solution[0][0]);
+    if (result.unique)
+    {
+      return;
+    }
+  }
+
+  // Doubtful cells: low confidence, or part of a conflict however confident
+  bool conflict[81];
+  find_conflicts(digits, conflict);
+  std::vector<SuspectCell> suspects;
+  for (int cell = 0; cell < 81; cell++)
+  {
+    int row = cell / 9;
+    int col = cell % 9;
+    if (!conflict[cell] && confidence[row][col] >= resolve_low_confidence)
+    {
+      continue;
+    }
+
+    SuspectCell suspect;
+    suspect.cell = cell;
+    suspect.confidence = conflict[cell] ? 0 : confidence[row][col];
+    suspect.options.push_back({digits[row][col], confidence[row][col]});
+    for (int k = 0; k < OCR_TOP_K; k++)
+    {
+      const DigitGuess &guess = ranked[row][col][k];
+      bool known = false;
+      for (const DigitGuess &option : suspect.options)
+      {
+        known = known || option.digit == guess.digit;
+      }
+      if (!known && guess.digit != 0)
+      {
+        suspect.options.push_back(guess);
+      }
+    }
+    // Лишняя цифра (шум, след от соседней ячейки) — тоже вариант: пустая
+    // ячейка тем вероятнее, чем слабее прочитана цифра
+    if (digits[row][col] != 0)
+    {
+      suspect.options.push_back({0, 1 - confidence[row][col]});
+    }
+    if (suspect.options.size() > 1)
+    {
+      suspects.push_back(suspect);
+    }
+  }
+
+  std::sort(suspects.begin(), suspects.end(),
+            [](const SuspectCell &a, const SuspectCell &b) { return a.confidence < b.confidence; });
+  if ((int)suspects.size() > resolve_max_cells)
+  {
+    suspects.resize(resolve_max_cells);
+  }
+  if (suspects.empty())
+  {
+    return;
+  }
+
+  // Every combination of options with its log-likelihood, best first
+  size_t combinations = 1;
+  for (const SuspectCell &suspect : suspects)
+  {
+    combinations *= suspect.options.size();
+  }
+  std::vector<std::pair<double, size_t>> order;
+  order.reserve(combinations);
+  for (size_t index = 1; index < combinations; index++) // 0 is the board as read
+  {
+    double likelihood = 0;
+    size_t rest = index;
+    for (const SuspectCell &suspect : suspects)
+    {
+      likelihood += log_score(suspect.options[rest % suspect.options.size()].score);
+      rest /= suspect.options.size();
+    }
+    order.push_back(std::make_pair(likelihood, index));
+  }
+  std::sort(order.begin(), order.end(),
+            [](const std::pair<double, size_t> &a, const std::pair<double, size_t> &b) { return a.first > b.first; });
+
+  int board[9][9];
+  for (const std::pair<double, size_t> &candidate : order)
+  {
+    if (result.attempts >= resolve_max_attempts)
+    {
+      break;
+    }
+
+    std::copy(&digits[0][0], &digits[0][0] + 81, &board[0][0]);
+    size_t rest = candidate.second;
+    for (const SuspectCell &suspect : suspects)
+    {
+      board[suspect.cell / 9][suspect.cell % 9] = suspect.options[rest % suspect.options.size()].digit;
+      rest /= suspect.options.size();
+    }
+    if (count_for(solver, board, result) != 1)
+    {
+      continue;
+    }
+
+    std::copy(&board[0][0], &board[0][0] + 81, &result.board[0][0]);
+    std::copy(&solver.board[0][0], &solver.board[0][0] + 81, &result.solution[0][0]);
+    result.solved = true;
+    result.unique = true;
+    rest = candidate.second;
+    for (const SuspectCell &suspect : suspects)
+    {
+      const DigitGuess &chosen = suspect.options[rest % suspect.options.size()];
+      rest /= suspect.options.size();
+      if (chosen.digit != suspect.options[0].digit)
+      {
+        CellCorrection correction = {suspect.cell / 9, suspect.cell % 9, suspect.options[0].digit, chosen.digit,
+                                     suspect.options[0].score, chosen.score};
+        result.corrections.push_back(correction);
+      }
+    }
+    return;
+  }
+}
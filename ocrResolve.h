@@ -0,0 +1,55 @@
+#pragma once
+
+// Разбор сомнительных ячеек после распознавания: вместо одной цифры на
+// ячейку распознаватель отдаёт несколько лучших вариантов с оценками, а здесь
+// выбирается самый вероятный набор подсказок, у которого ровно одно решение.
+
+#include <vector>
+
+// Сколько лучших вариантов распознаватель хранит для каждой ячейки
+static const int OCR_TOP_K = 3;
+
+/**
+ * One ranked reading of a cell: digit 0 means empty
+ */
+struct DigitGuess
+{
+  int digit;
+  double score; // template score, 0..1
+};
+
+struct CellCorrection
+{
+  int row;
+  int col;
+  int read_digit;      // what recognition returned
+  int corrected_digit; // what the resolver chose instead
+  double read_score;
+  double corrected_score;
+};
+
+struct Resolution
+{
+  int board[9][9];    // clues after corrections
+  int solution[9][9]; // valid when solved
+  bool solved;
+  bool unique;        // false: solved only as read, corrections did not help
+  std::vector<CellCorrection> corrections;
+  int attempts;       // candidate boards checked
+};
+
+// Ячейки ниже этой уверенности (и все участники конфликтов) считаются сомнительными
+extern double resolve_low_confidence;
+// Сколько самых сомнительных ячеек перебирать и сколько наборов проверять
+extern int resolve_max_cells;
+extern int resolve_max_attempts;
+
+/**
+ * Keeps the board as read if it has exactly one solution. Otherwise tries
+ * the alternatives of the doubtful cells, most likely combination first,
+ * and takes the first one that is consistent and has a unique solution.
+ * A doubtful digit may also turn out empty, scored 1 - its confidence.
+ * Falls back to the board as read (solved if it has any solution).
+ */
+void resolve_scanned_board(const int digits[9][9], const double confidence[9][9],
+                           const DigitGuess ranked[9][9][OCR_TOP_K], Resolution &result);
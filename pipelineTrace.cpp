@@ -0,0 +1,197 @@
+#include "pipelineTrace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+bool trace_enabled = false;
+size_t trace_max_events = 1 << 20;
+
+namespace {
+
+const char* STAGE_NAMES[STAGE_COUNT] = {"capture", "decode", "locate", "crop", "threshold",
+                                        "match", "solve", "display", "write"};
+
+// Логарифмическая гистограмма: 4 корзины на каждую степень двойки (точность ~25%)
+const int HISTOGRAM_BUCKETS = 64 * 4;
+
+struct StageStats {
+  std::atomic<uint64_t> count;
+  std::atomic<uint64_t> totalNs;
+  std::atomic<uint64_t> maxNs;
+  std::atomic<uint64_t> buckets[HISTOGRAM_BUCKETS];
+};
+
+struct TraceSpan {
+  uint8_t stage;
+  uint32_t thread;
+  uint64_t startNs;
+  uint64_t endNs;
+};
+
+StageStats stats[STAGE_COUNT];
+std::mutex spansMutex;
+std::vector<TraceSpan> spans;
+std::atomic<uint64_t> droppedSpans(0);
+std::atomic<uint32_t> nextThread(0);
+const uint64_t traceOrigin = traceNow();
+volatile std::sig_atomic_t dumpRequested = 0;
+
+int bucketIndex(uint64_t ns) {
+  if (ns < 4) {
+    return (int)ns;
+  }
+  int octave = 63 - __builtin_clzll(ns);
+  int sub = (int)((ns >> (octave - 2)) & 3);
+  return octave * 4 + sub;
+}
+
+// Верхняя граница корзины, нс
+uint64_t bucketLimit(int index) {
+  if (index < 4) {
+    return index + 1;
+  }
+  int octave = index / 4;
+  int sub = index % 4;
+  return (uint64_t)(4 + sub + 1) << (octave - 2);
+}
+
+double percentileMicros(const StageStats& stage, uint64_t count, double fraction) {
+  uint64_t rank = (uint64_t)(fraction * (count - 1)) + 1;
+  uint64_t seen = 0;
+  for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+    seen += stage.buckets[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return std::min(bucketLimit(i), stage.maxNs.load(std::memory_order_relaxed)) / 1000.0;
+    }
+  }
+  return stage.maxNs.load(std::memory_order_relaxed) / 1000.0;
+}
+
+uint32_t currentThread() {
+  thread_local uint32_t id = nextThread.fetch_add(1) + 1;
+  return id;
+}
+
+void onDumpSignal(int) {
+  dumpRequested = 1;
+}
+
+}  // namespace
+
+const char* traceStageName(TraceStage stage) {
+  return stage >= 0 && stage < STAGE_COUNT ? STAGE_NAMES[stage] : "unknown";
+}
+
+uint64_t traceNow() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void traceRecord(TraceStage stage, uint64_t startNs, uint64_t endNs) {
+  uint64_t ns = endNs - startNs;
+  StageStats& stageStats = stats[stage];
+  stageStats.count.fetch_add(1, std::memory_order_relaxed);
+  stageStats.totalNs.fetch_add(ns, std::memory_order_relaxed);
+  stageStats.buckets[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+  uint64_t previousMax = stageStats.maxNs.load(std::memory_order_relaxed);
+  while (ns > previousMax && !stageStats.maxNs.compare_exchange_weak(previousMax, ns)) {
+  }
+
+  TraceSpan span = {(uint8_t)stage, currentThread(), startNs, endNs};
+  std::lock_guard<std::mutex> lock(spansMutex);
+  if (spans.size() < trace_max_events) {
+    spans.push_back(span);
+  } else {
+    droppedSpans.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void traceReset() {
+  std::lock_guard<std::mutex> lock(spansMutex);
+  spans.clear();
+  droppedSpans = 0;
+  for (StageStats& stage : stats) {
+    stage.count = 0;
+    stage.totalNs = 0;
+    stage.maxNs = 0;
+    for (std::atomic<uint64_t>& bucket : stage.buckets) {
+      bucket = 0;
+    }
+  }
+}
+
+void writeTraceSummary(std::ostream& out) {
+  char line[160];
+  snprintf(line, sizeof(line), "%-10s %8s %10s %9s %9s %9s %9s %9s", "stage", "count", "total ms",
+           "mean us", "p50 us", "p90 us", "p99 us", "max us");
+  out << line << "\n";
+
+  for (int i = 0; i < STAGE_COUNT; ++i) {
+    const StageStats& stage = stats[i];
+    uint64_t count = stage.count.load(std::memory_order_relaxed);
+    if (count == 0) {
+      continue;
+    }
+    double totalNs = (double)stage.totalNs.load(std::memory_order_relaxed);
+    snprintf(line, sizeof(line), "%-10s %8llu %10.2f %9.1f %9.1f %9.1f %9.1f %9.1f", STAGE_NAMES[i],
+             (unsigned long long)count, totalNs / 1e6, totalNs / count / 1000.0,
+             percentileMicros(stage, count, 0.5), percentileMicros(stage, count, 0.9),
+             percentileMicros(stage, count, 0.99), stage.maxNs.load(std::memory_order_relaxed) / 1000.0);
+    out << line << "\n";
+  }
+
+  if (droppedSpans > 0) {
+    out << droppedSpans << " spans not kept for the trace file (trace_max_events = " << trace_max_events
+        << ")\n";
+  }
+}
+
+bool writeChromeTrace(const std::string& path) {
+  std::ofstream file(path, std::ios::trunc);
+  if (!file) {
+    std::cerr << "Failed writing trace " << path << std::endl;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(spansMutex);
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  char event[192];
+  for (size_t i = 0; i < spans.size(); ++i) {
+    const TraceSpan& span = spans[i];
+    // Время в микросекундах от старта процесса, события "X" — готовые отрезки
+    snprintf(event, sizeof(event),
+             "{\"name\":\"%s\",\"cat\":\"pipeline\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+             STAGE_NAMES[span.stage], span.thread, (span.startNs - traceOrigin) / 1000.0,
+             (span.endNs - span.startNs) / 1000.0, i + 1 < spans.size() ? "," : "");
+    file << event;
+  }
+  file << "]}\n";
+  return static_cast<bool>(file);
+}
+
+void traceInstallDumpSignal() {
+  std::signal(SIGUSR1, onDumpSignal);
+}
+
+bool traceDumpRequested() {
+  if (!dumpRequested) {
+    return false;
+  }
+  dumpRequested = 0;
+  return true;
+}
+
+bool traceDump(const std::string& path) {
+  writeTraceSummary(std::cerr);
+  if (!writeChromeTrace(path)) {
+    return false;
+  }
+  std::cerr << "Trace saved to " << path << std::endl;
+  return true;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+// Трассировка конвейера: захват экрана, декодирование, поиск сетки, нарезка,
+// бинаризация, сопоставление, решение и отрисовка. Замеры собираются
+// в гистограммы по этапам и по запросу сохраняются в формате Chrome trace
+// (chrome://tracing, ui.perfetto.dev).
+//
+// Пока trace_enabled == false, TRACE_SCOPE стоит одну проверку флага.
+// С -DSUDOKU_NO_TRACE замеры не компилируются совсем.
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+enum TraceStage {
+  STAGE_CAPTURE = 0,
+  STAGE_DECODE,
+  STAGE_LOCATE,
+  STAGE_CROP,
+  STAGE_THRESHOLD,
+  STAGE_MATCH,
+  STAGE_SOLVE,
+  STAGE_DISPLAY,
+  STAGE_WRITE,
+  STAGE_COUNT
+};
+
+// Включается один раз при старте, до запуска потоков (--trace <file>)
+extern bool trace_enabled;
+// Сколько отдельных отрезков хранить для Chrome trace; гистограммы считаются всегда
+extern size_t trace_max_events;
+
+const char* traceStageName(TraceStage stage);
+
+// Монотонное время, нс
+uint64_t traceNow();
+
+/**
+ * Adds one measured span to the stage histogram and, while there is room,
+ * to the event list. Safe to call from any thread.
+ */
+void traceRecord(TraceStage stage, uint64_t startNs, uint64_t endNs);
+
+/**
+ * Measures the enclosing scope
+ */
+class TraceScope {
+ public:
+  explicit TraceScope(TraceStage stage) : stage(stage), start(trace_enabled ? traceNow() : 0) {}
+  ~TraceScope() {
+    if (start != 0) {
+      traceRecord(stage, start, traceNow());
+    }
+  }
+
+ private:
+  TraceStage stage;
+  uint64_t start;
+};
+
+#ifdef SUDOKU_NO_TRACE
+#define TRACE_SCOPE(stage) ((void)0)
+#else
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_SCOPE(stage) TraceScope TRACE_JOIN(traceScope, __LINE__)(stage)
+#endif
+
+/**
+ * Forgets all spans and histograms
+ */
+void traceReset();
+
+/**
+ * Per-stage table: count, total, mean, p50/p90/p99 and max
+ */
+void writeTraceSummary(std::ostream& out);
+
+/**
+ * Saves the recorded spans as Chrome trace JSON
+ */
+bool writeChromeTrace(const std::string& path);
+
+/**
+ * SIGUSR1 asks a long-running process to dump its trace; the main loop
+ * polls traceDumpRequested() and calls traceDump() itself
+ */
+void traceInstallDumpSignal();
+bool traceDumpRequested();
+
+/**
+ * writeChromeTrace plus the summary on stderr
+ */
+bool traceDump(const std::string& path);
@@ -0,0 +1,263 @@
+// Подбор таблицы маршрутов портфеля решателей: каждая головоломка решается
+// каждым решателем по отдельности и каждой парой наперегонки, для каждой
+// корзины признаков выбирается вариант с наименьшим средним временем.
+//
+// Сборка:
+//   g++ -std=c++17 -O2 -o portfolioBench portfolioBench.cpp solverPortfolio.cpp sudokuEngine.cpp sudokuHints.cpp solveTrace.cpp -pthread
+//
+// Запуск:
+//   ./portfolioBench [--cap-ms N] [--min-samples N] [--output portfolio_routes.txt] <puzzles.txt>
+//
+// Решатель, не уложившийся в --cap-ms, отменяется, а в среднее идёт сам
+// лимит. Корзины, где головоломок меньше --min-samples, сохраняют
+// прежний маршрут.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "solverPortfolio.h"
+#include "sudokuEngine.h"
+
+// Отменяет решатель, если тот не уложился в срок
+class Watchdog {
+ public:
+  explicit Watchdog(PortfolioSolver& solver) : solver(solver), thread([this] { run(); }) {}
+
+  ~Watchdog() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+  }
+
+  void arm(std::chrono::milliseconds limit) {
+    std::lock_guard<std::mutex> lock(mutex);
+    deadline = std::chrono::steady_clock::now() + limit;
+    armed = true;
+    wake.notify_one();
+  }
+
+  void disarm() {
+    std::lock_guard<std::mutex> lock(mutex);
+    armed = false;
+  }
+
+ private:
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+      if (!armed) {
+        wake.wait(lock);
+      } else if (wake.wait_until(lock, deadline) == std::cv_status::timeout && armed) {
+        solver.cancel();
+        armed = false;
+      }
+    }
+  }
+
+  PortfolioSolver& solver;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::chrono::steady_clock::time_point deadline;
+  bool armed = false;
+  bool stopping = false;
+  std::thread thread;
+};
+
+int main(int argc, char** argv) {
+  int capMs = 200;
+  int minSamples = 5;
+  std::string outputPath = portfolio_routes_path;
+  std::string inputPath;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--cap-ms" && i + 1 < argc) {
+      capMs = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--min-samples" && i + 1 < argc) {
+      minSamples = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--output" && i + 1 < argc) {
+      outputPath = argv[++i];
+    } else {
+      inputPath = arg;
+    }
+  }
+
+  std::ifstream input(inputPath);
+  if (inputPath.empty() || !input) {
+    std::cerr << "Usage: " << argv[0] << " [--cap-ms N] [--min-samples N] [--output file] <puzzles.txt>" << std::endl;
+    return 1;
+  }
+  std::vector<std::string> puzzles;
+  std::string line;
+  while (std::getline(input, line)) {
+    int probe[9][9];
+    if (!line.empty() && line[0] != '#' && parse_puzzle(line, probe)) {
+      puzzles.push_back(line);
+    }
+  }
+  load_portfolio_routes(outputPath);  // недостаточно замеренные корзины остаются как были
+
+  // Варианты: каждый решатель отдельно и каждая пара наперегонки
+  std::vector<PortfolioRoute> options;
+  for (int a = 0; a < ENGINE_COUNT; ++a) {
+    options.push_back({a, ENGINE_NONE});
+  }
+  for (int a = 0; a < ENGINE_COUNT; ++a) {
+    for (int b = a + 1; b < ENGINE_COUNT; ++b) {
+      options.push_back({a, b});
+    }
+  }
+  auto optionName = [](const PortfolioRoute& route) {
+    return route.secondary == ENGINE_NONE
+               ? std::string(engine_name(route.primary))
+               : std::string(engine_name(route.primary)) + "|" + engine_name(route.secondary);
+  };
+
+  PortfolioSolver solver;
+  Watchdog watchdog(solver);
+  std::vector<std::vector<double>> totalUs(PORTFOLIO_BUCKETS, std::vector<double>(options.size()));
+  std::vector<int> samples(PORTFOLIO_BUCKETS);
+  std::vector<int> timeouts(options.size());
+  int disagreements = 0;
+  double featureUs = 0;  // цена маршрутизации: признаки считаются на каждую головоломку
+  int routedPuzzles = 0;
+  size_t measured = 0;
+
+  for (const std::string& text : puzzles) {
+    int puzzle[9][9], solution[9][9];
+    parse_puzzle(text, puzzle);
+    PuzzleFeatures features;
+    auto featuresStart = std::chrono::steady_clock::now();
+    extract_features(puzzle, features);
+    featureUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - featuresStart).count();
+    ++routedPuzzles;
+    if (features.conflict) {
+      continue;
+    }
+    ++samples[features.bucket];
+
+    // Первый вариант каждой головоломки платит за холодный кэш, поэтому
+    // начало обхода сдвигается от головоломки к головоломке
+    int solvedBy = 0, unsolvedBy = 0;
+    size_t first = measured++ % options.size();
+    for (size_t step = 0; step < options.size(); ++step) {
+      size_t option = (first + step) % options.size();
+      watchdog.arm(std::chrono::milliseconds(capMs));
+      auto start = std::chrono::steady_clock::now();
+      bool solved = solver.solve_with(options[option], puzzle, solution);
+      double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      watchdog.disarm();
+
+      bool timedOut = solver.winner() == ENGINE_NONE;
+      if (timedOut) {
+        ++timeouts[option];
+        us = capMs * 1000.0;
+      } else {
+        ++(solved ? solvedBy : unsolvedBy);
+      }
+      totalUs[features.bucket][option] += us;
+    }
+    disagreements += solvedBy > 0 && unsolvedBy > 0;
+  }
+
+  int column = 0;
+  for (const PortfolioRoute& route : options) {
+    column = std::max(column, (int)optionName(route).size() + 2);
+  }
+  std::cout << std::left << std::setw(36) << "bucket" << std::right << std::setw(8) << "puzzles";
+  for (const PortfolioRoute& route : options) {
+    std::cout << std::setw(column) << optionName(route);
+  }
+  std::cout << "   route (mean us)" << std::endl;
+
+  for (int bucket = 0; bucket < PORTFOLIO_BUCKETS; ++bucket) {
+    std::cout << std::left << std::setw(36) << bucket_name(bucket) << std::right << std::setw(8) << samples[bucket];
+    if (samples[bucket] == 0) {
+      std::cout << std::endl;
+      continue;
+    }
+    size_t best = 0;
+    for (size_t option = 0; option < options.size(); ++option) {
+      double mean = totalUs[bucket][option] / samples[bucket];
+      std::cout << std::setw(column) << std::fixed << std::setprecision(1) << mean;
+      if (totalUs[bucket][option] < totalUs[bucket][best]) {
+        best = option;
+      }
+    }
+    if (samples[bucket] >= minSamples) {
+      portfolio_routes[bucket] = options[best];
+    }
+    std::cout << "   " << optionName(portfolio_routes[bucket]) << (samples[bucket] < minSamples ? " (kept)" : "")
+              << std::endl;
+  }
+
+  for (size_t option = 0; option < options.size(); ++option) {
+    if (timeouts[option] > 0) {
+      std::cout << optionName(options[option]) << ": " << timeouts[option] << " over " << capMs << " ms" << std::endl;
+    }
+  }
+  if (disagreements > 0) {
+    std::cout << "Warning: engines disagreed on solvability of " << disagreements << " puzzles" << std::endl;
+  }
+
+  // Проверка таблицы: портфель против лучшего одиночного решателя. Оба
+  // решают каждую головоломку в одном проходе, первым — по очереди: второй
+  // запуск на той же головоломке заметно быстрее из-за прогретого кэша
+  double bestSingleUs = -1;
+  int bestSingle = 0;
+  for (int engine = 0; engine < ENGINE_COUNT; ++engine) {
+    double sum = 0;
+    for (int bucket = 0; bucket < PORTFOLIO_BUCKETS; ++bucket) {
+      sum += totalUs[bucket][engine];  // первые ENGINE_COUNT вариантов — одиночные решатели
+    }
+    if (bestSingleUs < 0 || sum < bestSingleUs) {
+      bestSingleUs = sum;
+      bestSingle = engine;
+    }
+  }
+  auto timeSolve = [&](const int puzzle[9][9], bool routed) {
+    int solution[9][9];
+    watchdog.arm(std::chrono::milliseconds(capMs));
+    auto start = std::chrono::steady_clock::now();
+    if (routed) {
+      solver.solve(puzzle, solution);
+    } else {
+      solver.solve_with({bestSingle, ENGINE_NONE}, puzzle, solution);
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    watchdog.disarm();
+    return std::min(capMs * 1000.0, us);
+  };
+  double routedUs = 0;
+  double singleUs = 0;
+  for (size_t i = 0; i < puzzles.size(); ++i) {
+    int puzzle[9][9];
+    parse_puzzle(puzzles[i], puzzle);
+    bool routedFirst = i % 2 == 0;
+    (routedFirst ? routedUs : singleUs) += timeSolve(puzzle, routedFirst);
+    (routedFirst ? singleUs : routedUs) += timeSolve(puzzle, !routedFirst);
+  }
+  std::cout << "Routed: " << std::fixed << std::setprecision(0) << routedUs << " us total, best single engine ("
+            << engine_name(bestSingle) << ") on the same pass: " << singleUs << " us" << std::endl;
+  std::cout << "Routing overhead: " << std::setprecision(2) << (routedPuzzles > 0 ? featureUs / routedPuzzles : 0)
+            << " us per puzzle for features (" << std::setprecision(0) << featureUs << " us of the routed total)"
+            << std::endl;
+
+  if (!save_portfolio_routes(outputPath)) {
+    std::cerr << "Failed writing " << outputPath << std::endl;
+    return 1;
+  }
+  std::cout << "Routes written to " << outputPath << std::endl;
+  return 0;
+}
@@ -0,0 +1,538 @@
+// Индекс корпуса головоломок: дубликаты и симметричные копии сводятся к
+// одной канонической записи с числом повторов, решением и сложностью.
+//
+// Сборка:
+//   g++ -std=c++17 -O2 -o puzzleCorpus puzzleCorpus.cpp puzzleIndex.cpp libsudoku.cpp sudokuEngine.cpp sudokuHints.cpp solveTrace.cpp -pthread
+//
+// Запуск:
+//   ./puzzleCorpus build [--memory MB] [--temp dir] [--threads N] --output corpus.idx <puzzles.txt|->...
+//   ./puzzleCorpus lookup corpus.idx <puzzle|puzzles.txt>
+//   ./puzzleCorpus stats corpus.idx
+//
+// build читает головоломки по строке (81 символ, '0' или '.' для пустых)
+// порциями не больше --memory, каждую порцию канонизирует, сортирует и
+// сворачивает в файл-прогон во временной папке, затем сливает прогоны
+// проходами по merge_fan_in за раз; буферы чтения тоже делят --memory.
+// Решение и сложность считаются только для уникальных головоломок.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "puzzleIndex.h"
+#include "libsudoku.h"
+#include "sudokuEngine.h"
+
+// Сколько уникальных головоломок оценивать за раз при слиянии
+size_t grade_block_size = 4096;
+// Сколько прогонов сливать за раз; если их больше, сначала идут промежуточные проходы
+size_t merge_fan_in = 64;
+
+// Запись прогона: отсортированы по (hash, puzzle), без повторов
+struct RunRecord {
+  uint64_t hash;
+  uint32_t count;
+  uint8_t puzzle[PACKED_GRID_SIZE];
+  uint8_t padding[3];
+};
+
+struct BuildOptions {
+  size_t memoryBytes = 256u << 20;
+  std::string tempDir = ".";
+  int threads = 1;
+  std::string outputPath;
+};
+
+struct BuildStats {
+  uint64_t read = 0;
+  uint64_t skipped = 0;  // строки, не похожие на головоломку
+  uint64_t unique = 0;
+  uint64_t statuses[3] = {};  // SUDOKU_OK, SUDOKU_NO_SOLUTION, SUDOKU_MULTIPLE_SOLUTIONS
+  uint64_t invalid = 0;
+};
+
+std::string gridString(const int grid[9][9]) {
+  std::string text(81, '0');
+  for (int cell = 0; cell < 81; ++cell) {
+    text[cell] = (char)('0' + grid[cell / 9][cell % 9]);
+  }
+  return text;
+}
+
+bool runLess(const RunRecord& a, const RunRecord& b) {
+  return compare_index_keys(a.hash, a.puzzle, b.hash, b.puzzle) < 0;
+}
+
+bool sameKey(const RunRecord& a, const RunRecord& b) {
+  return compare_index_keys(a.hash, a.puzzle, b.hash, b.puzzle) == 0;
+}
+
+// Раздаёт [0, count) поровну между потоками
+template <typename Work>
+void parallelFor(size_t count, int threads, Work work) {
+  std::vector<std::thread> pool;
+  size_t chunk = (count + threads - 1) / threads;
+  for (int t = 0; t < threads; ++t) {
+    size_t begin = t * chunk;
+    size_t end = std::min(count, begin + chunk);
+    if (begin < end) {
+      pool.emplace_back([begin, end, &work] {
+        for (size_t i = begin; i < end; ++i) {
+          work(i);
+        }
+      });
+    }
+  }
+  for (std::thread& thread : pool) {
+    thread.join();
+  }
+}
+
+std::string runPath(const BuildOptions& options, int runNumber) {
+  return options.tempDir + "/puzzleCorpus." + std::to_string(getpid()) + "." + std::to_string(runNumber) + ".run";
+}
+
+// Канонизирует порцию, сортирует, сворачивает повторы и пишет прогон
+bool writeRun(const std::vector<std::string>& lines, const BuildOptions& options, int runNumber,
+              std::vector<std::string>& runs, BuildStats& stats) {
+  std::vector<RunRecord> records(lines.size());
+  std::vector<char> parsed(lines.size());
+  parallelFor(lines.size(), options.threads, [&](size_t i) {
+    int puzzle[9][9], canonical[9][9];
+    PuzzleTransform transform;
+    parsed[i] = parse_puzzle(lines[i], puzzle);
+    if (!parsed[i]) {
+      return;
+    }
+    canonicalize_puzzle(puzzle, canonical, transform);
+    RunRecord& record = records[i];
+    std::memset(&record, 0, sizeof(record));
+    record.hash = puzzle_hash(canonical);
+    record.count = 1;
+    pack_grid(canonical, record.puzzle);
+  });
+
+  size_t kept = 0;
+  for (size_t i = 0; i < records.size(); ++i) {
+    if (parsed[i]) {
+      records[kept++] = records[i];
+    } else {
+      ++stats.skipped;
+    }
+  }
+  records.resize(kept);
+  std::sort(records.begin(), records.end(), runLess);
+
+  size_t unique = 0;
+  for (size_t i = 0; i < records.size(); ++i) {
+    if (unique > 0 && sameKey(records[unique - 1], records[i])) {
+      records[unique - 1].count += records[i].count;
+    } else {
+      records[unique++] = records[i];
+    }
+  }
+
+  std::string path = runPath(options, runNumber);
+  FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file) {
+    std::cerr << "Failed writing " << path << std::endl;
+    return false;
+  }
+  bool written = std::fwrite(records.data(), sizeof(RunRecord), unique, file) == unique;
+  written = std::fclose(file) == 0 && written;
+  runs.push_back(path);
+  std::cerr << "Run " << runNumber << ": " << lines.size() << " lines, " << unique << " unique" << std::endl;
+  return written;
+}
+
+// Оценивает порцию уникальных головоломок: статус, решение, сложность
+void gradeBlock(std::vector<IndexRecord>& block, int threads, BuildStats& stats) {
+  std::vector<sudoku_engine*> engines(threads);
+  for (sudoku_engine*& engine : engines) {
+    engine = sudoku_engine_create();
+  }
+  size_t chunk = (block.size() + threads - 1) / threads;
+  parallelFor(threads, threads, [&](size_t t) {
+    for (size_t i = t * chunk; i < std::min(block.size(), (t + 1) * chunk); ++i) {
+      IndexRecord& record = block[i];
+      int grid[9][9];
+      unpack_grid(record.puzzle, grid);
+      std::string puzzle = gridString(grid);
+
+      sudoku_grade_info info;
+      int status = sudoku_grade(engines[t], puzzle.c_str(), &info);
+      record.status = (int8_t)status;
+      record.level = status == SUDOKU_OK ? (uint8_t)info.level : 0;
+      record.clues = (uint8_t)std::count_if(puzzle.begin(), puzzle.end(), [](char c) { return c != '0'; });
+      record.nodes = (uint32_t)std::min<long long>(info.nodes, UINT32_MAX);
+      char solution[81];
+      if (status == SUDOKU_OK && sudoku_solve(engines[t], puzzle.c_str(), solution) == SUDOKU_OK) {
+        for (int cell = 0; cell < 81; ++cell) {
+          grid[cell / 9][cell % 9] = solution[cell] - '0';
+        }
+        pack_grid(grid, record.solution);
+      }
+    }
+  });
+  for (sudoku_engine* engine : engines) {
+    sudoku_engine_destroy(engine);
+  }
+  for (const IndexRecord& record : block) {
+    if (record.status >= SUDOKU_OK && record.status <= SUDOKU_MULTIPLE_SOLUTIONS) {
+      ++stats.statuses[record.status];
+    } else {
+      ++stats.invalid;
+    }
+  }
+}
+
+// k-путевое слияние группы прогонов: по записи в порядке ключей
+struct RunMerge {
+  struct Source {
+    FILE* file;
+    RunRecord record;
+  };
+  std::vector<Source> sources;
+  std::vector<std::vector<char>> buffers;
+  std::vector<size_t> heap;
+};
+
+// Буфер на каждый открытый файл: бюджет --memory делится между прогонами
+// группы и выходом
+size_t mergeBufferBytes(const BuildOptions& options, size_t files) {
+  return std::max<size_t>(64 << 10, options.memoryBytes / files);
+}
+
+void closeMerge(RunMerge& merge) {
+  for (RunMerge::Source& source : merge.sources) {
+    std::fclose(source.file);
+  }
+  merge.sources.clear();
+  merge.buffers.clear();
+  merge.heap.clear();
+}
+
+bool openMerge(RunMerge& merge, const std::string* paths, size_t count, size_t bufferBytes) {
+  for (size_t i = 0; i < count; ++i) {
+    FILE* file = std::fopen(paths[i].c_str(), "rb");
+    if (!file) {
+      std::cerr << "Failed reading " << paths[i] << std::endl;
+      closeMerge(merge);
+      return false;
+    }
+    merge.buffers.emplace_back(bufferBytes);
+    std::setvbuf(file, merge.buffers.back().data(), _IOFBF, bufferBytes);
+    merge.sources.push_back({file, {}});
+  }
+  for (size_t i = 0; i < merge.sources.size(); ++i) {
+    if (std::fread(&merge.sources[i].record, sizeof(RunRecord), 1, merge.sources[i].file) == 1) {
+      merge.heap.push_back(i);
+    }
+  }
+  std::make_heap(merge.heap.begin(), merge.heap.end(), [&merge](size_t a, size_t b) {
+    return runLess(merge.sources[b].record, merge.sources[a].record);
+  });
+  return true;
+}
+
+// Следующая запись по порядку ключей; повторы из разных прогонов идут подряд
+bool nextRecord(RunMerge& merge, RunRecord& record) {
+  auto later = [&merge](size_t a, size_t b) { return runLess(merge.sources[b].record, merge.sources[a].record); };
+  if (merge.heap.empty()) {
+    return false;
+  }
+  std::pop_heap(merge.heap.begin(), merge.heap.end(), later);
+  RunMerge::Source& source = merge.sources[merge.heap.back()];
+  record = source.record;
+  if (std::fread(&source.record, sizeof(RunRecord), 1, source.file) == 1) {
+    std::push_heap(merge.heap.begin(), merge.heap.end(), later);
+  } else {
+    merge.heap.pop_back();
+  }
+  return true;
+}
+
+// Сливает группу прогонов в один, сворачивая повторы
+bool mergeGroup(const std::string* paths, size_t count, const std::string& outputPath, const BuildOptions& options) {
+  size_t bufferBytes = mergeBufferBytes(options, count + 1);
+  RunMerge merge;
+  if (!openMerge(merge, paths, count, bufferBytes)) {
+    return false;
+  }
+  FILE* output = std::fopen(outputPath.c_str(), "wb");
+  if (!output) {
+    std::cerr << "Failed writing " << outputPath << std::endl;
+    closeMerge(merge);
+    return false;
+  }
+  std::vector<char> outputBuffer(bufferBytes);
+  std::setvbuf(output, outputBuffer.data(), _IOFBF, bufferBytes);
+
+  bool ok = true;
+  RunRecord pending, record;
+  bool havePending = false;
+  while (ok && nextRecord(merge, record)) {
+    if (havePending && sameKey(pending, record)) {
+      pending.count += record.count;
+      continue;
+    }
+    ok = !havePending || std::fwrite(&pending, sizeof(RunRecord), 1, output) == 1;
+    pending = record;
+    havePending = true;
+  }
+  ok = ok && (!havePending || std::fwrite(&pending, sizeof(RunRecord), 1, output) == 1);
+  ok = std::fclose(output) == 0 && ok;
+  closeMerge(merge);
+  if (!ok) {
+    std::cerr << "Failed writing " << outputPath << std::endl;
+  }
+  return ok;
+}
+
+// Промежуточные проходы: сливает прогоны группами по merge_fan_in, пока
+// их не останется столько, чтобы последний проход открыл все сразу
+bool reduceRuns(std::vector<std::string>& runs, const BuildOptions& options, int& runNumber) {
+  size_t fanIn = std::max<size_t>(2, merge_fan_in);
+  for (int pass = 1; runs.size() > fanIn; ++pass) {
+    std::vector<std::string> merged;
+    bool ok = true;
+    for (size_t first = 0; ok && first < runs.size(); first += fanIn) {
+      size_t count = std::min(fanIn, runs.size() - first);
+      if (count == 1) {
+        merged.push_back(runs[first]);
+        continue;
+      }
+      merged.push_back(runPath(options, runNumber++));
+      ok = mergeGroup(&runs[first], count, merged.back(), options);
+      for (size_t i = first; ok && i < first + count; ++i) {
+        std::remove(runs[i].c_str());
+      }
+    }
+    if (!ok) {
+      // Вызывающий удалит и исходные прогоны, и уже слитые
+      runs.insert(runs.end(), merged.begin(), merged.end());
+      return false;
+    }
+    std::cerr << "Merge pass " << pass << ": " << runs.size() << " runs into " << merged.size() << std::endl;
+    runs.swap(merged);
+  }
+  return true;
+}
+
+// Сливает прогоны (после промежуточных проходов — не больше merge_fan_in)
+// k-путевым слиянием и пишет индекс
+bool mergeRuns(std::vector<std::string>& runs, const BuildOptions& options, BuildStats& stats) {
+  int runNumber = (int)runs.size();
+  if (!reduceRuns(runs, options, runNumber)) {
+    return false;
+  }
+  RunMerge merge;
+  if (!openMerge(merge, runs.data(), runs.size(), mergeBufferBytes(options, runs.size() + 1))) {
+    return false;
+  }
+
+  // Пишем во временный файл, заголовок — в конце, когда известно число записей
+  std::string temporary = options.outputPath + ".tmp";
+  FILE* output = std::fopen(temporary.c_str(), "wb");
+  if (!output) {
+    std::cerr << "Failed writing " << temporary << std::endl;
+    closeMerge(merge);
+    return false;
+  }
+  IndexHeader header = {};
+  std::fwrite(&header, sizeof(header), 1, output);
+
+  std::vector<IndexRecord> block;
+  bool ok = true;
+  auto flush = [&] {
+    gradeBlock(block, options.threads, stats);
+    ok = ok && std::fwrite(block.data(), sizeof(IndexRecord), block.size(), output) == block.size();
+    stats.unique += block.size();
+    block.clear();
+  };
+
+  RunRecord record;
+  while (nextRecord(merge, record)) {
+    if (!block.empty() && block.back().hash == record.hash &&
+        std::memcmp(block.back().puzzle, record.puzzle, PACKED_GRID_SIZE) == 0) {
+      block.back().count += record.count;
+    } else {
+      // Прогоны сливаются по порядку ключей, так что повторов у прошлой записи больше не будет
+      if (block.size() >= grade_block_size) {
+        flush();
+      }
+      IndexRecord fresh = {};
+      fresh.hash = record.hash;
+      fresh.count = record.count;
+      std::memcpy(fresh.puzzle, record.puzzle, PACKED_GRID_SIZE);
+      block.push_back(fresh);
+    }
+  }
+  flush();
+  closeMerge(merge);
+
+  std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+  header.version = INDEX_VERSION;
+  header.records = stats.unique;
+  header.puzzles = stats.read - stats.skipped;
+  ok = ok && std::fseek(output, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, output) == 1;
+  ok = std::fclose(output) == 0 && ok;
+  if (!ok || std::rename(temporary.c_str(), options.outputPath.c_str()) != 0) {
+    std::cerr << "Failed writing " << options.outputPath << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int build(const std::vector<std::string>& inputs, const BuildOptions& options) {
+  size_t runCapacity = std::max<size_t>(1024, options.memoryBytes / (sizeof(RunRecord) + 128));
+  std::vector<std::string> runs;
+  std::vector<std::string> lines;
+  BuildStats stats;
+  bool ok = true;
+
+  for (const std::string& inputPath : inputs) {
+    std::ifstream file;
+    if (inputPath != "-") {
+      file.open(inputPath);
+      if (!file) {
+        std::cerr << "Failed reading puzzles from " << inputPath << std::endl;
+        ok = false;
+        break;
+      }
+    }
+    std::istream& input = inputPath == "-" ? std::cin : file;
+    std::string line;
+    while (ok && std::getline(input, line)) {
+      if (line.empty() || line[0] == '#') {
+        continue;
+      }
+      lines.push_back(line);
+      ++stats.read;
+      if (lines.size() == runCapacity) {
+        ok = writeRun(lines, options, (int)runs.size(), runs, stats);
+        lines.clear();
+      }
+    }
+  }
+  if (ok && !lines.empty()) {
+    ok = writeRun(lines, options, (int)runs.size(), runs, stats);
+  }
+  lines.clear();
+  lines.shrink_to_fit();
+
+  ok = ok && mergeRuns(runs, options, stats);
+  for (const std::string& run : runs) {
+    std::remove(run.c_str());
+  }
+  if (!ok) {
+    return 1;
+  }
+
+  std::cerr << stats.read << " puzzles read (" << stats.skipped << " skipped), " << stats.unique << " unique: "
+            << stats.statuses[SUDOKU_OK] << " proper, " << stats.statuses[SUDOKU_MULTIPLE_SOLUTIONS]
+            << " with several solutions, " << stats.statuses[SUDOKU_NO_SOLUTION] << " unsolvable, " << stats.invalid
+            << " with conflicting givens" << std::endl;
+  return 0;
+}
+
+int lookup(const PuzzleIndex& index, const std::string& source) {
+  std::vector<std::string> puzzles;
+  int probe[9][9];
+  if (parse_puzzle(source, probe)) {
+    puzzles.push_back(source);
+  } else {
+    std::ifstream file(source);
+    std::string line;
+    while (std::getline(file, line)) {
+      if (!line.empty() && line[0] != '#') {
+        puzzles.push_back(line);
+      }
+    }
+  }
+
+  for (const std::string& text : puzzles) {
+    int puzzle[9][9], solution[9][9];
+    if (!parse_puzzle(text, puzzle)) {
+      continue;
+    }
+    const IndexRecord* record = index.lookup(puzzle, solution);
+    std::cout << gridString(puzzle);
+    if (!record) {
+      std::cout << " missing" << std::endl;
+      continue;
+    }
+    std::cout << " count=" << record->count << " status=" << (int)record->status << " level=" << (int)record->level
+              << " clues=" << (int)record->clues << " nodes=" << record->nodes;
+    if (record->status == SUDOKU_OK) {
+      std::cout << " " << gridString(solution);
+    }
+    std::cout << std::endl;
+  }
+  return 0;
+}
+
+int stats(const PuzzleIndex& index) {
+  uint64_t levels[5] = {};
+  uint64_t duplicated = 0;
+  uint32_t mostCopies = 0;
+  for (size_t i = 0; i < index.size(); ++i) {
+    const IndexRecord& record = index.record(i);
+    ++levels[std::min<int>(record.level, 4)];
+    duplicated += record.count > 1;
+    mostCopies = std::max(mostCopies, record.count);
+  }
+  std::cout << index.puzzles() << " puzzles, " << index.size() << " unique, " << duplicated
+            << " occur more than once (up to " << mostCopies << " times)" << std::endl;
+  const char* names[5] = {"not proper", "easy", "medium", "hard", "expert"};
+  for (int level = 0; level <= 4; ++level) {
+    std::cout << "  " << names[level] << ": " << levels[level] << std::endl;
+  }
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  std::string command = argc > 1 ? argv[1] : "";
+  if (command == "build") {
+    BuildOptions options;
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> inputs;
+    for (int i = 2; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--memory" && i + 1 < argc) {
+        options.memoryBytes = std::max(1ll, std::atoll(argv[++i])) << 20;
+      } else if (arg == "--temp" && i + 1 < argc) {
+        options.tempDir = argv[++i];
+      } else if (arg == "--threads" && i + 1 < argc) {
+        options.threads = std::max(1, std::atoi(argv[++i]));
+      } else if (arg == "--output" && i + 1 < argc) {
+        options.outputPath = argv[++i];
+      } else {
+        inputs.push_back(arg);
+      }
+    }
+    if (options.outputPath.empty() || inputs.empty()) {
+      std::cerr << "build needs --output and at least one input" << std::endl;
+      return 1;
+    }
+    return build(inputs, options);
+  }
+
+  if ((command == "lookup" && argc > 3) || (command == "stats" && argc > 2)) {
+    PuzzleIndex index;
+    if (!index.open(argv[2])) {
+      std::cerr << "Failed opening index " << argv[2] << std::endl;
+      return 1;
+    }
+    return command == "lookup" ? lookup(index, argv[3]) : stats(index);
+  }
+
+  std::cerr << "Usage: " << argv[0] << " build|lookup|stats ..." << std::endl;
+  return 1;
+}
@@ -0,0 +1,341 @@
+#include "puzzleIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+
+/**
+ * Depth-first branch and bound over row choices: a row that comes out larger
+ * than the best grid's row at the same depth cuts the whole branch, so only
+ * ties are explored further
+ */
+struct Canonicalizer
+{
+  int source[2][9][9]; // the puzzle and its transpose
+  int best[9][9];
+  int defined; // rows of best that are valid
+  PuzzleTransform current;
+  PuzzleTransform found;
+
+  /**
+   * First row: columns are chosen one at a time (stack order and order
+   * within each stack) so a prefix larger than the best first row cuts
+   * every column order that starts with it
+   */
+  void search_columns(int row, int col, const int relabel[10], int next_label, unsigned used_cols, int values[9])
+  {
+    if (col == 9)
+    {
+      current.rows[0] = row;
+      if (compare_prefix(values, 9) < 0)
+      {
+        std::copy(values, values + 9, best[0]);
+        defined = 1;
+      }
+      search(1, relabel, next_label, 1u << row);
+      return;
+    }
+
+    const int(*grid)[9] = source[current.transposed ? 1 : 0];
+    int first = 0;
+    int last = 8;
+    if (col % 3 != 0)
+    {
+      first = current.cols[col - col % 3] / 3 * 3;
+      last = first + 2;
+    }
+    for (int source_col = first; source_col <= last; source_col++)
+    {
+      if ((used_cols >> source_col) & 1 || (col % 3 == 0 && (used_cols >> (source_col / 3 * 3)) & 7))
+      {
+        continue;
+      }
+      int labels[10];
+      std::copy(relabel, relabel + 10, labels);
+      int next = next_label;
+      int digit = grid[row][source_col];
+      if (digit != 0 && labels[digit] == 0)
+      {
+        labels[digit] = next++;
+      }
+      values[col] = labels[digit];
+      // Лучшая первая строка могла смениться в соседней ветке, сравниваем заново
+      if (compare_prefix(values, col + 1) > 0)
+      {
+        continue;
+      }
+      current.cols[col] = source_col;
+      search_columns(row, col + 1, labels, next, used_cols | 1u << source_col, values);
+    }
+  }
+
+  // Сравнение начала первой строки с лучшей; без лучшей любая строка меньше
+  int compare_prefix(const int values[9], int length) const
+  {
+    if (defined == 0)
+    {
+      return -1;
+    }
+    for (int c = 0; c < length; c++)
+    {
+      if (values[c] != best[0][c])
+      {
+        return values[c] < best[0][c] ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  void search(int depth, const int relabel[10], int next_label, unsigned used_rows)
+  {
+    if (depth == 9)
+    {
+      found = current;
+      std::copy(relabel, relabel + 10, found.relabel);
+      for (int digit = 1; digit <= 9; digit++) // цифры, которых нет в головоломке
+      {
+        if (found.relabel[digit] == 0)
+        {
+          found.relabel[digit] = next_label++;
+        }
+      }
+      return;
+    }
+
+    const int(*grid)[9] = source[current.transposed ? 1 : 0];
+    int first = 0;
+    int last = 8;
+    if (depth % 3 != 0) // продолжаем полосу, начатую строкой depth - depth % 3
+    {
+      first = current.rows[depth - depth % 3] / 3 * 3;
+      last = first + 2;
+    }
+
+    for (int row = first; row <= last; row++)
+    {
+      if ((used_rows >> row) & 1 || (depth % 3 == 0 && (used_rows >> (row / 3 * 3)) & 7))
+      {
+        continue;
+      }
+
+      int labels[10];
+      std::copy(relabel, relabel + 10, labels);
+      int next = next_label;
+      int values[9];
+      int order = depth < defined ? 0 : -1; // -1: уже меньше лучшего
+      for (int c = 0; c < 9 && order != 1; c++)
+      {
+        int digit = grid[row][current.cols[c]];
+        if (digit != 0 && labels[digit] == 0)
+        {
+          labels[digit] = next++;
+        }
+        values[c] = labels[digit];
+        if (order == 0 && values[c] != best[depth][c])
+        {
+          order = values[c] < best[depth][c] ? -1 : 1;
+        }
+      }
+      if (order == 1)
+      {
+        continue;
+      }
+      if (order == -1)
+      {
+        std::copy(values, values + 9, best[depth]);
+        defined = depth + 1;
+      }
+
+      current.rows[depth] = row;
+      search(depth + 1, labels, next, used_rows | 1u << row);
+    }
+  }
+};
+
+} // namespace
+
+void canonicalize_puzzle(const int puzzle[9][9], int canonical[9][9], PuzzleTransform &transform)
+{
+  Canonicalizer canon;
+  for (int row = 0; row < 9; row++)
+  {
+    for (int col = 0; col < 9; col++)
+    {
+      canon.source[0][row][col] = puzzle[row][col];
+      canon.source[1][col][row] = puzzle[row][col];
+    }
+  }
+  canon.defined = 0;
+
+  int relabel[10] = {};
+  int values[9];
+  for (int transposed = 0; transposed < 2; transposed++)
+  {
+    canon.current.transposed = transposed != 0;
+    for (int row = 0; row < 9; row++)
+    {
+      canon.search_columns(row, 0, relabel, 1, 0, values);
+    }
+  }
+
+  transform = canon.found;
+  std::copy(&canon.best[0][0], &canon.best[0][0] + 81, &canonical[0][0]);
+}
+
+void apply_inverse_transform(const PuzzleTransform &transform, const int canonical[9][9], int original[9][9])
+{
+  int digits[10] = {};
+  for (int digit = 1; digit <= 9; digit++)
+  {
+    digits[transform.relabel[digit]] = digit;
+  }
+  for (int row = 0; row < 9; row++)
+  {
+    for (int col = 0; col < 9; col++)
+    {
+      int source_row = transform.rows[row];
+      int source_col = transform.cols[col];
+      if (transform.transposed)
+      {
+        std::swap(source_row, source_col);
+      }
+      original[source_row][source_col] = digits[canonical[row][col]];
+    }
+  }
+}
+
+uint64_t puzzle_hash(const int canonical[9][9])
+{
+  // FNV-1a и перемешивание splitmix64, чтобы старшие биты тоже зависели от всех клеток
+  uint64_t hash = 14695981039346656037ULL;
+  for (int cell = 0; cell < 81; cell++)
+  {
+    hash = (hash ^ (uint64_t)canonical[cell / 9][cell % 9]) * 1099511628211ULL;
+  }
+  hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+  return hash ^ (hash >> 31);
+}
+
+void pack_grid(const int grid[9][9], uint8_t packed[PACKED_GRID_SIZE])
+{
+  std::memset(packed, 0, PACKED_GRID_SIZE);
+  for (int cell = 0; cell < 81; cell++)
+  {
+    packed[cell / 2] |= (uint8_t)(grid[cell / 9][cell % 9] << (cell % 2 * 4));
+  }
+}
+
+void unpack_grid(const uint8_t packed[PACKED_GRID_SIZE], int grid[9][9])
+{
+  for (int cell = 0; cell < 81; cell++)
+  {
+    grid[cell / 9][cell % 9] = (packed[cell / 2] >> (cell % 2 * 4)) & 0xF;
+  }
+}
+
+int compare_index_keys(uint64_t hash_a, const uint8_t *puzzle_a, uint64_t hash_b, const uint8_t *puzzle_b)
+{
+  if (hash_a != hash_b)
+  {
+    return hash_a < hash_b ? -1 : 1;
+  }
+  return std::memcmp(puzzle_a, puzzle_b, PACKED_GRID_SIZE);
+}
+
+PuzzleIndex::PuzzleIndex() : mapping(nullptr), mapping_size(0), header(nullptr), records(nullptr)
+{
+}
+
+PuzzleIndex::~PuzzleIndex()
+{
+  close();
+}
+
+bool PuzzleIndex::open(const char *path)
+{
+  close();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(IndexHeader))
+  {
+    ::close(fd);
+    return false;
+  }
+  void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED)
+  {
+    return false;
+  }
+  mapping = data;
+  mapping_size = info.st_size;
+
+  const IndexHeader *candidate = static_cast<const IndexHeader *>(data);
+  if (std::memcmp(candidate->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || candidate->version != INDEX_VERSION ||
+      mapping_size != sizeof(IndexHeader) + candidate->records * sizeof(IndexRecord))
+  {
+    close();
+    return false;
+  }
+  header = candidate;
+  records = reinterpret_cast<const IndexRecord *>(header + 1);
+  return true;
+}
+
+void PuzzleIndex::close()
+{
+  if (mapping)
+  {
+    munmap(mapping, mapping_size);
+  }
+  mapping = nullptr;
+  mapping_size = 0;
+  header = nullptr;
+  records = nullptr;
+}
+
+const IndexRecord *PuzzleIndex::find(const int canonical[9][9]) const
+{
+  if (!header)
+  {
+    return nullptr;
+  }
+  uint64_t hash = puzzle_hash(canonical);
+  uint8_t packed[PACKED_GRID_SIZE];
+  pack_grid(canonical, packed);
+
+  const IndexRecord *end = records + header->records;
+  const IndexRecord *found = std::lower_bound(records, end, packed, [hash](const IndexRecord &record, const uint8_t *key) {
+    return compare_index_keys(record.hash, record.puzzle, hash, key) < 0;
+  });
+  if (found == end || compare_index_keys(found->hash, found->puzzle, hash, packed) != 0)
+  {
+    return nullptr;
+  }
+  return found;
+}
+
+const IndexRecord *PuzzleIndex::lookup(const int puzzle[9][9], int solution[9][9]) const
+{
+  int canonical[9][9];
+  PuzzleTransform transform;
+  canonicalize_puzzle(puzzle, canonical, transform);
+  const IndexRecord *found = find(canonical);
+  if (found && found->solution[0] != 0)
+  {
+    int canonical_solution[9][9];
+    unpack_grid(found->solution, canonical_solution);
+    apply_inverse_transform(transform, canonical_solution, solution);
+  }
+  return found;
+}
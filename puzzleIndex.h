@@ -0,0 +1,115 @@
+#pragma once
+
+// Канонический вид головоломки и индекс корпуса на диске.
+//
+// Головоломки, которые переводятся друг в друга перестановками строк внутри
+// полосы, полос, столбцов внутри стопки, стопок, транспонированием и
+// переименованием цифр, имеют один канонический вид и один хэш.
+// puzzleCorpus строит индекс уникальных головоломок, puzzleCorpus lookup и
+// shardSolve --index берут из него готовые решения.
+//
+// Формат файла (little-endian): IndexHeader, затем IndexRecord[records],
+// отсортированные по (hash, puzzle). Файл читается через mmap, поиск —
+// двоичный по хэшу.
+
+#include <cstddef>
+#include <cstdint>
+
+static const char INDEX_MAGIC[4] = {'S', 'D', 'K', 'I'};
+static const uint32_t INDEX_VERSION = 1;
+static const int PACKED_GRID_SIZE = 41; // две клетки на байт
+
+/**
+ * Symmetry taking a puzzle to its canonical form: after an optional
+ * transpose, canonical[r][c] = relabel[source[rows[r]][cols[c]]]
+ */
+struct PuzzleTransform
+{
+  bool transposed;
+  int rows[9];
+  int cols[9];
+  int relabel[10]; // relabel[0] = 0, a permutation of 1..9 otherwise
+};
+
+/**
+ * Smallest grid, in row order with empty cells first, over all symmetries
+ * of the puzzle. Digits are renumbered in order of first appearance.
+ */
+void canonicalize_puzzle(const int puzzle[9][9], int canonical[9][9], PuzzleTransform &transform);
+
+/**
+ * Maps a grid in the canonical frame (e.g. the canonical solution) back to
+ * the frame of the puzzle the transform was computed for
+ */
+void apply_inverse_transform(const PuzzleTransform &transform, const int canonical[9][9], int original[9][9]);
+
+uint64_t puzzle_hash(const int canonical[9][9]);
+
+void pack_grid(const int grid[9][9], uint8_t packed[PACKED_GRID_SIZE]);
+void unpack_grid(const uint8_t packed[PACKED_GRID_SIZE], int grid[9][9]);
+
+struct IndexHeader
+{
+  char magic[4];
+  uint32_t version;
+  uint64_t records; // unique puzzles
+  uint64_t puzzles; // puzzles read, duplicates included
+};
+
+struct IndexRecord
+{
+  uint64_t hash;
+  uint32_t count;  // occurrences in the corpus, symmetric copies included
+  uint32_t nodes;  // search nodes needed to prove the solution unique
+  int8_t status;   // libsudoku code: SUDOKU_OK, SUDOKU_NO_SOLUTION, ...
+  uint8_t level;   // sudoku_grade level, 0 if the puzzle is not proper
+  uint8_t clues;
+  uint8_t reserved;
+  uint8_t puzzle[PACKED_GRID_SIZE];   // canonical form
+  uint8_t solution[PACKED_GRID_SIZE]; // of the canonical form, zeros if none
+  uint8_t padding[2];
+};
+
+static_assert(sizeof(IndexRecord) == 104, "IndexRecord is part of the file format");
+
+/**
+ * Order of records in the index and in the sort runs
+ */
+int compare_index_keys(uint64_t hash_a, const uint8_t *puzzle_a, uint64_t hash_b, const uint8_t *puzzle_b);
+
+/**
+ * Read-only view of an index file
+ */
+class PuzzleIndex
+{
+public:
+  PuzzleIndex();
+  ~PuzzleIndex();
+  PuzzleIndex(const PuzzleIndex &) = delete;
+  PuzzleIndex &operator=(const PuzzleIndex &) = delete;
+
+  bool open(const char *path);
+  void close();
+  bool is_open() const { return header != nullptr; }
+
+  size_t size() const { return header ? header->records : 0; }
+  uint64_t puzzles() const { return header ? header->puzzles : 0; }
+  const IndexRecord &record(size_t i) const { return records[i]; }
+
+  /**
+   * Record of a puzzle already in canonical form, nullptr if absent
+   */
+  const IndexRecord *find(const int canonical[9][9]) const;
+
+  /**
+   * Record of any puzzle, up to symmetry. If the record has a solution it is
+   * written to solution in the puzzle's own frame.
+   */
+  const IndexRecord *lookup(const int puzzle[9][9], int solution[9][9]) const;
+
+private:
+  void *mapping;
+  size_t mapping_size;
+  const IndexHeader *header;
+  const IndexRecord *records;
+};
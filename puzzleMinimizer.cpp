@@ -0,0 +1,378 @@
+// Минимизация головоломок и поиск головоломок с малым числом подсказок.
+// Подсказки убираются по одной, пока каждая оставшаяся не станет
+// необходимой: без неё у головоломки появилось бы второе решение.
+//
+// Сборка:
+//   g++ -std=c++17 -O2 -o puzzleMinimizer puzzleMinimizer.cpp sudokuEngine.cpp solveTrace.cpp -pthread
+//
+// Запуск:
+//   ./puzzleMinimizer [опции] <puzzles.txt>   минимизировать каждую строку файла
+//   ./puzzleMinimizer [опции] --search N       сгенерировать N случайных сеток и минимизировать их
+// Опции:
+//   --attempts K         случайных порядков удаления на головоломку (по умолчанию 10)
+//   --max-clues C        записывать только головоломки с числом подсказок <= C
+//   --threads T          рабочих потоков (по умолчанию все ядра)
+//   --seed S             начальное зерно (зерно задания i выводится из S и i)
+//   --output file        куда писать (по умолчанию stdout)
+//   --checkpoint file    сохранять прогресс и продолжать с него после перезапуска;
+//                        вывод обрезается до сохранённого места, а задания,
+//                        завершённые после сохранения, выполняются заново.
+//                        Продолжить можно только с теми же входом и опциями.
+//
+// Строки вывода: <81 цифра> <число подсказок> <номер задания>.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "sudokuEngine.h"
+
+int checkpoint_interval_seconds = 30;
+
+struct MinimizerOptions {
+  int attempts = 10;
+  int maxClues = 81;
+  unsigned long long seed = 1;
+  long long searchGrids = -1;  // -1: минимизируются головоломки из inputPath
+  std::string inputPath;
+  std::string outputPath;
+  std::string checkpointPath;
+};
+
+// Общее состояние заданий: раздача номеров, отметки о завершении, вывод
+struct JobState {
+  size_t jobCount = 0;
+  std::vector<std::string> inputs;  // пусто в режиме поиска
+  std::atomic<size_t> nextJob{0};
+
+  std::mutex mutex;
+  std::vector<char> done;
+  size_t watermark = 0;  // все задания ниже него завершены
+  int bestClues = 82;
+  long long written = 0;
+  std::atomic<long long> checks{0};
+  FILE* output = stdout;
+};
+
+std::string puzzleString(const int puzzle[9][9]) {
+  std::string text(81, '0');
+  for (int cell = 0; cell < 81; ++cell) {
+    text[cell] = (char)('0' + puzzle[cell / 9][cell % 9]);
+  }
+  return text;
+}
+
+uint64_t nextRandom(uint64_t& state) {
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 2685821657736338717ULL;
+}
+
+/**
+ * One pass over the clues in random order, dropping every clue that is not
+ * essential. A clue found essential stays essential as more clues go, so
+ * one pass leaves a minimal puzzle.
+ */
+int minimizeOnce(BitmaskSolver& solver, const int puzzle[9][9], uint64_t& random, int result[9][9],
+                 std::atomic<long long>& checks) {
+  solver.load(puzzle);
+  int order[81];
+  int clues = 0;
+  for (int cell = 0; cell < 81; ++cell) {
+    if (puzzle[cell / 9][cell % 9] != 0) {
+      order[clues++] = cell;
+    }
+  }
+  for (int i = clues - 1; i > 0; --i) {
+    std::swap(order[i], order[nextRandom(random) % (i + 1)]);
+  }
+
+  std::copy(&puzzle[0][0], &puzzle[0][0] + 81, &result[0][0]);
+  int remaining = clues;
+  long long localChecks = 0;
+  for (int i = 0; i < clues; ++i) {
+    int cell = order[i];
+    ++localChecks;
+    if (!solver.clue_is_essential(cell)) {
+      solver.set_clue(cell, 0);
+      result[cell / 9][cell % 9] = 0;
+      --remaining;
+    }
+  }
+  checks += localChecks;
+  return remaining;
+}
+
+// Опции, от которых зависит вывод: продолжать можно только с теми же
+std::vector<std::pair<std::string, std::string>> runIdentity(const JobState& jobs, const MinimizerOptions& options) {
+  return {{"seed", std::to_string(options.seed)},
+          {"search", std::to_string(options.searchGrids)},
+          {"input", options.inputPath},
+          {"jobs", std::to_string(jobs.jobCount)},
+          {"attempts", std::to_string(options.attempts)},
+          {"max_clues", std::to_string(options.maxClues)},
+          {"output", options.outputPath}};
+}
+
+// Вызывается под jobs.mutex: смещение вывода и отметки заданий согласованы
+void saveCheckpoint(JobState& jobs, const MinimizerOptions& options) {
+  if (options.checkpointPath.empty()) {
+    return;
+  }
+  // Пишем во временный файл и переименовываем, чтобы не оставить половину файла
+  std::string temporary = options.checkpointPath + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::trunc);
+    for (const auto& option : runIdentity(jobs, options)) {
+      file << option.first << " " << option.second << "\n";
+    }
+    file << "next_job " << jobs.watermark << "\n"
+         << "best_clues " << jobs.bestClues << "\n"
+         << "written " << jobs.written << "\n"
+         << "checks " << jobs.checks.load() << "\n"
+         << "output_offset " << (jobs.output == stdout ? -1L : std::ftell(jobs.output)) << "\n";
+    // Завершённые не по порядку, выше next_job
+    for (size_t job = jobs.watermark; job < jobs.jobCount; ++job) {
+      if (jobs.done[job]) {
+        file << "done " << job << "\n";
+      }
+    }
+  }
+  std::rename(temporary.c_str(), options.checkpointPath.c_str());
+}
+
+// false, если контрольная точка сделана с другими опциями или входом
+bool loadCheckpoint(JobState& jobs, const MinimizerOptions& options, long long& outputOffset) {
+  std::ifstream file(options.checkpointPath);
+  std::map<std::string, std::string> saved;
+  std::string line;
+  while (std::getline(file, line)) {
+    size_t space = line.find(' ');
+    std::string key = line.substr(0, space);
+    std::string value = space == std::string::npos ? "" : line.substr(space + 1);
+    long long number = std::atoll(value.c_str());
+    if (key == "next_job") {
+      jobs.watermark = std::min((size_t)number, jobs.jobCount);
+    } else if (key == "best_clues") {
+      jobs.bestClues = (int)number;
+    } else if (key == "written") {
+      jobs.written = number;
+    } else if (key == "checks") {
+      jobs.checks = number;
+    } else if (key == "output_offset") {
+      outputOffset = number;
+    } else if (key == "done") {
+      if (number >= 0 && (size_t)number < jobs.jobCount) {
+        jobs.done[number] = 1;
+      }
+    } else {
+      saved[key] = value;
+    }
+  }
+
+  for (const auto& option : runIdentity(jobs, options)) {
+    auto found = saved.find(option.first);
+    if (found == saved.end() || found->second != option.second) {
+      std::cerr << "Checkpoint " << options.checkpointPath << " belongs to a run with " << option.first << " "
+                << (found == saved.end() ? "unknown" : found->second) << ", not " << option.second
+                << "; refusing to resume" << std::endl;
+      return false;
+    }
+  }
+  std::fill(jobs.done.begin(), jobs.done.begin() + jobs.watermark, 1);
+  std::cerr << "Resuming from job " << jobs.watermark << std::endl;
+  return true;
+}
+
+void worker(JobState& jobs, const MinimizerOptions& options) {
+  BitmaskSolver solver;            // состояние решателя живёт весь поток
+  SolutionEnumerator generator;    // случайные полные сетки для поиска
+  int empty[9][9] = {};
+
+  while (true) {
+    size_t job = jobs.nextJob++;
+    if (job >= jobs.jobCount) {
+      break;
+    }
+    if (jobs.done[job]) {
+      continue;  // завершено до перезапуска, строка уже в выводе
+    }
+
+    uint64_t random = options.seed + job * 0x9E3779B97F4A7C15ULL;
+    if (random == 0) {
+      random = 1;
+    }
+    int puzzle[9][9];
+    bool usable;
+    if (jobs.inputs.empty()) {
+      generator.set_random_order(random);
+      usable = generator.load(empty) && generator.next(puzzle);
+    } else {
+      usable = parse_puzzle(jobs.inputs[job], puzzle) && solver.load(puzzle) && solver.count_solutions(2) == 1;
+      if (!usable) {
+        std::cerr << "Job " << job << ": not a puzzle with a unique solution, skipped" << std::endl;
+      }
+    }
+
+    int best[9][9];
+    int bestClues = 82;
+    for (int attempt = 0; usable && attempt < options.attempts; ++attempt) {
+      int minimal[9][9];
+      int clues = minimizeOnce(solver, puzzle, random, minimal, jobs.checks);
+      if (clues < bestClues) {
+        bestClues = clues;
+        std::copy(&minimal[0][0], &minimal[0][0] + 81, &best[0][0]);
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(jobs.mutex);
+    if (usable && bestClues <= options.maxClues) {
+      std::fprintf(jobs.output, "%s %d %zu\n", puzzleString(best).c_str(), bestClues, job);
+      std::fflush(jobs.output);
+      ++jobs.written;
+    }
+    if (usable && bestClues < jobs.bestClues) {
+      jobs.bestClues = bestClues;
+      std::cerr << "Job " << job << ": new best " << bestClues << " clues" << std::endl;
+    }
+    jobs.done[job] = 1;
+    while (jobs.watermark < jobs.jobCount && jobs.done[jobs.watermark]) {
+      ++jobs.watermark;
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  MinimizerOptions options;
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  long long& searchGrids = options.searchGrids;
+  std::string& inputPath = options.inputPath;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--attempts" && i + 1 < argc) {
+      options.attempts = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--max-clues" && i + 1 < argc) {
+      options.maxClues = std::atoi(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      threads = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--seed" && i + 1 < argc) {
+      options.seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--output" && i + 1 < argc) {
+      options.outputPath = argv[++i];
+    } else if (arg == "--checkpoint" && i + 1 < argc) {
+      options.checkpointPath = argv[++i];
+    } else if (arg == "--search" && i + 1 < argc) {
+      searchGrids = std::atoll(argv[++i]);
+    } else {
+      inputPath = arg;
+    }
+  }
+
+  JobState jobs;
+  if (searchGrids >= 0) {
+    jobs.jobCount = (size_t)searchGrids;
+  } else {
+    std::ifstream input(inputPath.empty() ? "sudoku.txt" : inputPath);
+    std::string line;
+    if (inputPath.empty()) {
+      // sudoku.txt: одна головоломка в 9 строках
+      std::string text;
+      while (std::getline(input, line)) {
+        text += line;
+      }
+      jobs.inputs.push_back(text);
+    } else {
+      while (std::getline(input, line)) {
+        if (!line.empty() && line[0] != '#') {
+          jobs.inputs.push_back(line);
+        }
+      }
+    }
+    if (!input.eof() || jobs.inputs.empty()) {
+      std::cerr << "Failed reading puzzles from " << (inputPath.empty() ? "sudoku.txt" : inputPath) << std::endl;
+      return 1;
+    }
+    jobs.jobCount = jobs.inputs.size();
+  }
+  jobs.done.assign(jobs.jobCount, 0);
+
+  bool resumed = false;
+  long long outputOffset = -1;
+  if (!options.checkpointPath.empty() && std::ifstream(options.checkpointPath)) {
+    if (!loadCheckpoint(jobs, options, outputOffset)) {
+      return 1;
+    }
+    resumed = true;
+    jobs.nextJob = jobs.watermark;
+  }
+  if (!options.outputPath.empty()) {
+    // При продолжении дописываем к уже найденному, отрезав строки заданий,
+    // завершённых после сохранения: они выполнятся заново
+    jobs.output = std::fopen(options.outputPath.c_str(), resumed ? "a" : "w");
+    if (!jobs.output) {
+      std::cerr << "Failed writing " << options.outputPath << std::endl;
+      return 1;
+    }
+    if (resumed) {
+      std::fseek(jobs.output, 0, SEEK_END);
+      if (outputOffset < 0 || std::ftell(jobs.output) < outputOffset ||
+          ftruncate(fileno(jobs.output), outputOffset) != 0) {
+        std::cerr << options.outputPath << " does not match the checkpoint, refusing to resume" << std::endl;
+        return 1;
+      }
+      std::fseek(jobs.output, 0, SEEK_END);
+    }
+  }
+
+  auto started = std::chrono::steady_clock::now();
+  long long checksAtStart = jobs.checks;
+  std::vector<std::thread> pool;
+  for (int i = 0; i < threads; ++i) {
+    pool.emplace_back(worker, std::ref(jobs), std::cref(options));
+  }
+
+  // Отдельный поток периодически сохраняет прогресс
+  std::mutex finishMutex;
+  std::condition_variable finishSignal;
+  bool finished = false;
+  std::thread checkpointer([&] {
+    std::unique_lock<std::mutex> wait(finishMutex);
+    while (!finishSignal.wait_for(wait, std::chrono::seconds(checkpoint_interval_seconds), [&] { return finished; })) {
+      std::lock_guard<std::mutex> lock(jobs.mutex);
+      saveCheckpoint(jobs, options);
+    }
+  });
+
+  for (std::thread& thread : pool) {
+    thread.join();
+  }
+  {
+    std::lock_guard<std::mutex> lock(finishMutex);
+    finished = true;
+  }
+  finishSignal.notify_one();
+  checkpointer.join();
+  saveCheckpoint(jobs, options);
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  long long checks = jobs.checks - checksAtStart;
+  std::cerr << jobs.jobCount << " jobs, " << jobs.written << " puzzles written, best " << jobs.bestClues
+            << " clues; " << checks << " uniqueness checks in " << seconds << " s ("
+            << (seconds > 0 ? (long long)(checks / seconds) : 0) << "/s, " << threads << " threads)" << std::endl;
+  if (jobs.output != stdout) {
+    std::fclose(jobs.output);
+  }
+  return 0;
+}
@@ -0,0 +1,511 @@
+// Решение больших наборов головоломок несколькими процессами. Координатор
+// запускает N рабочих процессов (fork) и обменивается с каждым через два
+// кольцевых буфера в общей памяти: головоломки туда, результаты обратно.
+// Упавший или зависший на одной головоломке рабочий перезапускается, его
+// невыполненные задания раздаются заново, а вывод остаётся в порядке ввода.
+//
+// Сборка:
+//   g++ -std=c++17 -O2 -o shardSolve shardSolve.cpp sudokuEngine.cpp solveTrace.cpp puzzleIndex.cpp
+//
+// Запуск:
+//   ./shardSolve [--workers N] [--timeout-ms T] [--pin] [--index corpus.idx] [--output file] <puzzles.txt|->
+//
+// На входе по головоломке в строке (81 символ, '0' или '.' для пустых),
+// на выходе строка на каждую: <решение или исходная головоломка> <статус>,
+// статус — solved, multiple, unsolvable, invalid, timeout или crashed.
+// --pin закрепляет рабочего i за процессором i (по кругу среди доступных).
+// --index берёт решения из индекса puzzleCorpus, перебор — только для
+// головоломок, которых там нет. Приведение к каноническому виду стоит
+// около 0.4 мс, так что индекс окупается на трудных наборах, а не на
+// типичных головоломках, которые решаются быстрее.
+
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "libsudoku.h"
+#include "puzzleIndex.h"
+#include "sudokuEngine.h"
+
+// Слотов в каждом кольце и сколько заданий держать у одного рабочего
+const uint32_t SHARD_RING_SLOTS = 64;
+int shard_worker_depth = 16;
+// Сколько головоломок может ждать записи, пока медленная задерживает вывод
+size_t shard_window = 4096;
+// Головоломка дольше этого считается зависанием, рабочий перезапускается
+int shard_puzzle_timeout_ms = 2000;
+// Сколько раз повторять головоломку, на которой рабочий упал или завис
+int shard_max_retries = 1;
+
+// Открывается до fork, рабочие наследуют отображение
+PuzzleIndex shard_index;
+bool shard_use_index = false;
+
+enum ShardStatus { SHARD_SOLVED, SHARD_MULTIPLE, SHARD_UNSOLVABLE, SHARD_INVALID, SHARD_TIMEOUT, SHARD_CRASHED };
+const char* SHARD_STATUS_NAMES[] = {"solved", "multiple", "unsolvable", "invalid", "timeout", "crashed"};
+
+struct PuzzleSlot {
+  uint64_t index;
+  char cells[81];
+};
+
+struct ResultSlot {
+  uint64_t index;
+  int32_t status;
+  char cells[81];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared-memory rings need lock-free atomics");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory rings need lock-free atomics");
+
+// Кольцо с одним писателем и одним читателем. Счётчики лежат в разных
+// кэш-линиях, слот публикуется release-записью head и забирается
+// acquire-чтением, блокировок нет.
+template <typename Slot>
+struct SharedRing {
+  alignas(64) std::atomic<uint32_t> head;  // пишет производитель
+  alignas(64) std::atomic<uint32_t> tail;  // пишет потребитель
+  alignas(64) Slot slots[SHARD_RING_SLOTS];
+
+  bool push(const Slot& slot) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == SHARD_RING_SLOTS) {
+      return false;
+    }
+    slots[h % SHARD_RING_SLOTS] = slot;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(Slot& slot) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    slot = slots[t % SHARD_RING_SLOTS];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+// Общая память одного рабочего
+struct WorkerShared {
+  SharedRing<PuzzleSlot> requests;
+  SharedRing<ResultSlot> results;
+  alignas(64) std::atomic<uint64_t> current;  // номер решаемой головоломки + 1, 0 — простаивает
+  std::atomic<int64_t> startedNs;             // когда начата текущая (steady_clock)
+  std::atomic<uint32_t> stop;
+};
+
+int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void pause(int idleRounds) {
+  if (idleRounds < 64) {
+    sched_yield();
+  } else {
+    usleep(50);
+  }
+}
+
+int solvePuzzle(BitmaskSolver& solver, const char cells[81], char solution[81]) {
+  int puzzle[9][9];
+  for (int cell = 0; cell < 81; ++cell) {
+    char c = cells[cell] == '.' ? '0' : cells[cell];
+    if (c < '0' || c > '9') {
+      return SHARD_INVALID;
+    }
+    puzzle[cell / 9][cell % 9] = c - '0';
+  }
+  if (shard_use_index) {
+    // Для нескольких решений индекс решения не хранит, такие решаем перебором
+    int known[9][9];
+    const IndexRecord* record = shard_index.lookup(puzzle, known);
+    if (record && record->status == SUDOKU_NO_SOLUTION) {
+      return SHARD_UNSOLVABLE;
+    }
+    if (record && record->status == SUDOKU_OK) {
+      for (int cell = 0; cell < 81; ++cell) {
+        solution[cell] = (char)('0' + known[cell / 9][cell % 9]);
+      }
+      return SHARD_SOLVED;
+    }
+  }
+  if (!solver.load(puzzle)) {
+    return SHARD_UNSOLVABLE;
+  }
+  int count = solver.count_solutions(2);
+  if (count == 0) {
+    return SHARD_UNSOLVABLE;
+  }
+  for (int cell = 0; cell < 81; ++cell) {
+    solution[cell] = (char)('0' + solver.board[cell / 9][cell % 9]);
+  }
+  return count == 1 ? SHARD_SOLVED : SHARD_MULTIPLE;
+}
+
+[[noreturn]] void workerMain(WorkerShared& shared, int cpu) {
+  prctl(PR_SET_PDEATHSIG, SIGKILL);  // не переживать координатора
+  if (cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+  }
+
+  BitmaskSolver solver;
+  PuzzleSlot request;
+  ResultSlot result;
+  int idleRounds = 0;
+  while (true) {
+    if (!shared.requests.pop(request)) {
+      if (shared.stop.load(std::memory_order_acquire)) {
+        break;
+      }
+      pause(idleRounds++);
+      continue;
+    }
+    idleRounds = 0;
+    shared.startedNs.store(nowNs(), std::memory_order_relaxed);
+    shared.current.store(request.index + 1, std::memory_order_release);
+
+    result.index = request.index;
+    std::memcpy(result.cells, request.cells, 81);
+    result.status = solvePuzzle(solver, request.cells, result.cells);
+    while (!shared.results.push(result)) {
+      pause(64);
+    }
+    shared.current.store(0, std::memory_order_release);
+  }
+  _exit(0);
+}
+
+// Головоломка между чтением и записью
+struct WindowEntry {
+  char cells[81];
+  bool done = false;
+  int status = SHARD_INVALID;
+  char answer[81];
+  int failures = 0;
+};
+
+struct WorkerSlot {
+  WorkerShared* shared = nullptr;
+  pid_t pid = -1;
+  std::deque<uint64_t> outstanding;  // отправлено, результата ещё нет, в порядке отправки
+  bool killedForHang = false;
+  int cpu = -1;
+};
+
+class Coordinator {
+ public:
+  Coordinator(std::istream& input, FILE* output, int workers, bool pin)
+      : input(input), output(output), workers(workers) {
+    shared = (WorkerShared*)mmap(nullptr, sizeof(WorkerShared) * workers, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+      shared = nullptr;
+      return;
+    }
+    std::vector<int> cpus;
+    cpu_set_t allowed;
+    if (pin && sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+          cpus.push_back(cpu);
+        }
+      }
+    }
+    for (int i = 0; i < workers; ++i) {
+      WorkerSlot& worker = this->workers[i];
+      worker.shared = &shared[i];
+      worker.cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+    }
+  }
+
+  ~Coordinator() {
+    if (shared) {
+      munmap(shared, sizeof(WorkerShared) * workers.size());
+    }
+  }
+
+  bool ready() const { return shared != nullptr; }
+
+  int run() {
+    for (size_t i = 0; i < workers.size(); ++i) {
+      if (!startWorker(i)) {
+        return 1;
+      }
+    }
+
+    int64_t started = nowNs();
+    int idleRounds = 0;
+    while (true) {
+      bool progress = readInput();
+      for (size_t i = 0; i < workers.size(); ++i) {
+        progress = collectResults(i) | progress;
+        progress = dispatch(i) | progress;
+      }
+      progress = writeFinished() | progress;
+      progress = watchWorkers() | progress;
+      if (inputDone && window.empty()) {
+        break;
+      }
+      if (progress) {
+        idleRounds = 0;
+      } else {
+        pause(idleRounds++);
+      }
+    }
+
+    for (WorkerSlot& worker : workers) {
+      worker.shared->stop.store(1, std::memory_order_release);
+    }
+    for (WorkerSlot& worker : workers) {
+      waitpid(worker.pid, nullptr, 0);
+    }
+
+    double seconds = (nowNs() - started) / 1e9;
+    std::cerr << written << " puzzles (";
+    for (int status = SHARD_SOLVED; status <= SHARD_CRASHED; ++status) {
+      std::cerr << (status ? ", " : "") << statusCounts[status] << " " << SHARD_STATUS_NAMES[status];
+    }
+    std::cerr << ") in " << seconds << " s, " << (seconds > 0 ? (long long)(written / seconds) : 0)
+              << " puzzles/s, " << workers.size() << " workers, " << restarts << " restarts" << std::endl;
+    return 0;
+  }
+
+ private:
+  bool startWorker(size_t i) {
+    WorkerSlot& worker = workers[i];
+    // Новый рабочий получает чистые кольца: старые задания раздаются заново
+    new (worker.shared) WorkerShared();
+    worker.shared->requests.head = worker.shared->requests.tail = 0;
+    worker.shared->results.head = worker.shared->results.tail = 0;
+    worker.shared->current = 0;
+    worker.shared->stop = 0;
+    worker.outstanding.clear();
+    worker.killedForHang = false;
+
+    std::fflush(output);  // буфер stdio не должен достаться ребёнку
+    pid_t pid = fork();
+    if (pid < 0) {
+      std::perror("fork");
+      return false;
+    }
+    if (pid == 0) {
+      workerMain(*worker.shared, worker.cpu);
+    }
+    worker.pid = pid;
+    return true;
+  }
+
+  WindowEntry& entry(uint64_t index) { return window[index - firstUnwritten]; }
+
+  bool readInput() {
+    bool progress = false;
+    std::string line;
+    while (!inputDone && window.size() < shard_window) {
+      if (!std::getline(input, line)) {
+        inputDone = true;
+        break;
+      }
+      if (line.empty() || line[0] == '#') {
+        continue;
+      }
+      WindowEntry fresh;
+      std::memset(fresh.cells, '?', 81);  // короткая строка станет invalid
+      std::memcpy(fresh.cells, line.data(), std::min<size_t>(line.size(), 81));
+      window.push_back(fresh);
+      pending.push_back(nextIndex++);
+      progress = true;
+    }
+    return progress;
+  }
+
+  bool dispatch(size_t i) {
+    WorkerSlot& worker = workers[i];
+    bool progress = false;
+    PuzzleSlot slot;
+    while (!pending.empty() && worker.outstanding.size() < (size_t)shard_worker_depth) {
+      slot.index = pending.front();
+      std::memcpy(slot.cells, entry(slot.index).cells, 81);
+      if (!worker.shared->requests.push(slot)) {
+        break;
+      }
+      pending.pop_front();
+      worker.outstanding.push_back(slot.index);
+      progress = true;
+    }
+    return progress;
+  }
+
+  bool collectResults(size_t i) {
+    WorkerSlot& worker = workers[i];
+    bool progress = false;
+    ResultSlot result;
+    while (worker.shared->results.pop(result)) {
+      // Рабочий решает по порядку, так что результат — для первого отправленного
+      worker.outstanding.pop_front();
+      WindowEntry& finished = entry(result.index);
+      finished.done = true;
+      finished.status = result.status;
+      std::memcpy(finished.answer, result.cells, 81);
+      progress = true;
+    }
+    return progress;
+  }
+
+  bool writeFinished() {
+    bool progress = false;
+    char line[84];
+    while (!window.empty() && window.front().done) {
+      const WindowEntry& finished = window.front();
+      std::memcpy(line, finished.answer, 81);
+      line[81] = 0;
+      std::fprintf(output, "%s %s\n", line, SHARD_STATUS_NAMES[finished.status]);
+      ++statusCounts[finished.status];
+      ++written;
+      window.pop_front();
+      ++firstUnwritten;
+      progress = true;
+    }
+    return progress;
+  }
+
+  bool watchWorkers() {
+    bool progress = false;
+    int64_t now = nowNs();
+    for (WorkerSlot& worker : workers) {
+      uint64_t current = worker.shared->current.load(std::memory_order_acquire);
+      int64_t startedNs = worker.shared->startedNs.load(std::memory_order_relaxed);
+      if (current != 0 && !worker.killedForHang && now - startedNs > (int64_t)shard_puzzle_timeout_ms * 1000000) {
+        kill(worker.pid, SIGKILL);
+        worker.killedForHang = true;
+      }
+    }
+
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+      for (size_t i = 0; i < workers.size(); ++i) {
+        if (workers[i].pid == pid) {
+          recoverWorker(i, status);
+          progress = true;
+        }
+      }
+    }
+    return progress;
+  }
+
+  void recoverWorker(size_t i, int status) {
+    WorkerSlot& worker = workers[i];
+    collectResults(i);  // всё, что рабочий успел решить, остаётся в силе
+
+    uint64_t current = worker.shared->current.load(std::memory_order_acquire);
+    if (current != 0 && !worker.outstanding.empty() && worker.outstanding.front() == current - 1) {
+      WindowEntry& culprit = entry(current - 1);
+      if (++culprit.failures > shard_max_retries) {
+        culprit.done = true;
+        culprit.status = worker.killedForHang ? SHARD_TIMEOUT : SHARD_CRASHED;
+        std::memcpy(culprit.answer, culprit.cells, 81);
+        worker.outstanding.pop_front();
+      }
+    }
+    std::cerr << "Worker " << worker.pid << " "
+              << (worker.killedForHang ? "hung" : WIFSIGNALED(status) ? strsignal(WTERMSIG(status)) : "exited")
+              << (current ? " on puzzle " + std::to_string(current - 1) : std::string()) << ", restarting"
+              << std::endl;
+
+    // Остальное — в начало очереди, чтобы не задерживать запись
+    pending.insert(pending.begin(), worker.outstanding.begin(), worker.outstanding.end());
+    ++restarts;
+    startWorker(i);
+  }
+
+  std::istream& input;
+  FILE* output;
+  WorkerShared* shared = nullptr;
+  std::vector<WorkerSlot> workers;
+
+  std::deque<WindowEntry> window;  // головоломки с firstUnwritten по nextIndex - 1
+  std::deque<uint64_t> pending;    // ещё не отправлены ни одному рабочему
+  uint64_t firstUnwritten = 0;
+  uint64_t nextIndex = 0;
+  bool inputDone = false;
+
+  long long written = 0;
+  long long statusCounts[SHARD_CRASHED + 1] = {};
+  long long restarts = 0;
+};
+
+int main(int argc, char** argv) {
+  int workers = std::max(1l, sysconf(_SC_NPROCESSORS_ONLN));
+  bool pin = false;
+  std::string inputPath = "-";
+  std::string outputPath;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--workers" && i + 1 < argc) {
+      workers = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--timeout-ms" && i + 1 < argc) {
+      shard_puzzle_timeout_ms = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--pin") {
+      pin = true;
+    } else if (arg == "--index" && i + 1 < argc) {
+      if (!shard_index.open(argv[++i])) {
+        std::cerr << "Failed opening index " << argv[i] << std::endl;
+        return 1;
+      }
+      shard_use_index = true;
+    } else if (arg == "--output" && i + 1 < argc) {
+      outputPath = argv[++i];
+    } else {
+      inputPath = arg;
+    }
+  }
+
+  std::ifstream file;
+  if (inputPath != "-") {
+    file.open(inputPath);
+    if (!file) {
+      std::cerr << "Failed reading puzzles from " << inputPath << std::endl;
+      return 1;
+    }
+  }
+  FILE* output = stdout;
+  if (!outputPath.empty() && !(output = std::fopen(outputPath.c_str(), "w"))) {
+    std::cerr << "Failed writing " << outputPath << std::endl;
+    return 1;
+  }
+
+  Coordinator coordinator(inputPath == "-" ? std::cin : file, output, workers, pin);
+  if (!coordinator.ready()) {
+    std::perror("mmap");
+    return 1;
+  }
+  int result = coordinator.run();
+  if (output != stdout) {
+    std::fclose(output);
+  }
+  return result;
+}
@@ -0,0 +1,137 @@
+#include "solveTrace.h"
+#include <fstream>
+#include <sstream>
+
+static const char *EVENT_NAMES[] = {"", "place", "remove", "propagate"};
+
+SolveTrace::SolveTrace(size_t ring_capacity)
+    : ring_head(0), ring_tail(0), dropped(0), recording_enabled(false), max_recorded(0), truncated(false),
+      recorded_count(0)
+{
+  // Round up to a power of two so the index can be masked
+  size_t capacity = 1;
+  while (capacity < ring_capacity)
+  {
+    capacity <<= 1;
+  }
+  ring.resize(capacity);
+  ring_mask = capacity - 1;
+}
+
+void SolveTrace::reset(bool record, size_t max_recorded)
+{
+  ring_head.store(0);
+  ring_tail.store(0);
+  dropped.store(0);
+  recording_enabled = record;
+  this->max_recorded = max_recorded;
+  truncated = false;
+  chunks.clear();
+  recorded_count = 0;
+}
+
+void SolveTrace::drain(std::vector<SolveEvent> &events)
+{
+  size_t tail = ring_tail.load(std::memory_order_relaxed);
+  size_t head = ring_head.load(std::memory_order_acquire);
+  for (; tail != head; tail++)
+  {
+    events.push_back(ring[tail & ring_mask]);
+  }
+  ring_tail.store(tail, std::memory_order_release);
+}
+
+void SolveTrace::take_recording(std::vector<SolveEvent> &events)
+{
+  events.clear();
+  events.reserve(recorded_count);
+  for (size_t chunk = 0; chunk < chunks.size(); chunk++)
+  {
+    size_t left = recorded_count - chunk * RECORD_CHUNK;
+    size_t count = left < RECORD_CHUNK ? left : RECORD_CHUNK;
+    events.insert(events.end(), chunks[chunk].get(), chunks[chunk].get() + count);
+  }
+  chunks.clear();
+  recorded_count = 0;
+}
+
+bool save_trace(const std::string &path, const std::string &engine, const int puzzle[9][9],
+                const std::vector<SolveEvent> &events)
+{
+  std::ofstream file(path, std::ios::trunc);
+  if (!file)
+  {
+    return false;
+  }
+
+  file << "# sudoku solve trace v1 engine=" << engine << " events=" << events.size() << "\n";
+  for (int i = 0; i < 9; i++)
+  {
+    for (int j = 0; j < 9; j++)
+    {
+      file << puzzle[i][j];
+    }
+  }
+  file << "\n";
+
+  for (const SolveEvent &event : events)
+  {
+    file << EVENT_NAMES[event.type] << " " << event.cell / 9 << " " << event.cell % 9 << " "
+         << (int)event.digit << "\n";
+  }
+  return static_cast<bool>(file);
+}
+
+bool load_trace(const std::string &path, std::string &engine, int puzzle[9][9],
+                std::vector<SolveEvent> &events)
+{
+  std::ifstream file(path);
+  std::string line;
+  if (!std::getline(file, line) || line.compare(0, 23, "# sudoku solve trace v1") != 0)
+  {
+    return false;
+  }
+  size_t engine_at = line.find("engine=");
+  engine = engine_at == std::string::npos ? "" : line.substr(engine_at + 7, line.find(' ', engine_at) - engine_at - 7);
+
+  if (!std::getline(file, line) || line.size() < 81)
+  {
+    return false;
+  }
+  for (int i = 0; i < 81; i++)
+  {
+    if (line[i] < '0' || line[i] > '9')
+    {
+      return false;
+    }
+    puzzle[i / 9][i % 9] = line[i] - '0';
+  }
+
+  events.clear();
+  while (std::getline(file, line))
+  {
+    std::istringstream fields(line);
+    std::string name;
+    int row, col, digit;
+    if (!(fields >> name >> row >> col >> digit) || row < 0 || row > 8 || col < 0 || col > 8 ||
+        digit < 0 || digit > 9)
+    {
+      return false;
+    }
+
+    SolveEvent event = {0, (uint8_t)(row * 9 + col), (uint8_t)digit, 0};
+    for (int type = EVENT_PLACE; type <= EVENT_PROPAGATE; type++)
+    {
+      if (name == EVENT_NAMES[type])
+      {
+        event.type = type;
+      }
+    }
+    if (event.type == 0)
+    {
+      return false;
+    }
+    events.push_back(event);
+  }
+  return true;
+}
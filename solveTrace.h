@@ -0,0 +1,125 @@
+#pragma once
+
+// Журнал шагов решателя: компактные события (поставить, убрать, вывести
+// из ограничений) для пошаговой визуализации, повтора и сравнения решателей.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum SolveEventType
+{
+  EVENT_PLACE = 1,     // digit placed by search
+  EVENT_REMOVE = 2,    // digit taken back on backtrack
+  EVENT_PROPAGATE = 3  // digit forced by constraint propagation
+};
+
+struct SolveEvent
+{
+  uint8_t type;
+  uint8_t cell; // row * 9 + col
+  uint8_t digit;
+  uint8_t reserved;
+};
+
+/**
+ * Solver-side sink for events. The solving thread pushes into a lock-free
+ * single-producer/single-consumer ring that the GUI drains once per frame;
+ * when the ring is full events are dropped instead of blocking the solver.
+ * Optionally every event is also appended to a full recording for saving
+ * and replay. The recording is kept in fixed-size chunks, so the solver
+ * never waits on a vector reallocating and copying millions of events.
+ */
+class SolveTrace
+{
+public:
+  explicit SolveTrace(size_t ring_capacity = 1 << 16);
+
+  /**
+   * Clears the ring, counters and recording; call before the solve starts
+   */
+  void reset(bool record, size_t max_recorded = 20000000);
+
+  /**
+   * Called by the solver thread
+   */
+  void push(SolveEventType type, int cell, int digit)
+  {
+    SolveEvent event = {(uint8_t)type, (uint8_t)cell, (uint8_t)digit, 0};
+
+    size_t head = ring_head.load(std::memory_order_relaxed);
+    if (head - ring_tail.load(std::memory_order_acquire) < ring.size())
+    {
+      ring[head & ring_mask] = event;
+      ring_head.store(head + 1, std::memory_order_release);
+    }
+    else
+    {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (recording_enabled)
+    {
+      if (recorded_count < max_recorded)
+      {
+        size_t offset = recorded_count & (RECORD_CHUNK - 1);
+        if (offset == 0)
+          chunks.emplace_back(new SolveEvent[RECORD_CHUNK]);
+        chunks.back()[offset] = event;
+        recorded_count++;
+      }
+      else
+        truncated = true;
+    }
+  }
+
+  /**
+   * Called by the consumer thread: moves everything queued so far into events
+   */
+  void drain(std::vector<SolveEvent> &events);
+
+  /**
+   * Events lost because the consumer fell behind (live view must resync)
+   */
+  size_t dropped_events() const { return dropped.load(std::memory_order_relaxed); }
+
+  /**
+   * Size of the full recording; only read it after the solving thread is done
+   */
+  size_t recorded_events() const { return recorded_count; }
+  bool recording_truncated() const { return truncated; }
+
+  /**
+   * Moves the full recording into events (one copy out of the chunks)
+   * and frees it; only call after the solving thread is done
+   */
+  void take_recording(std::vector<SolveEvent> &events);
+
+private:
+  std::vector<SolveEvent> ring;
+  size_t ring_mask;
+  std::atomic<size_t> ring_head;
+  std::atomic<size_t> ring_tail;
+  std::atomic<size_t> dropped;
+
+  bool recording_enabled;
+  size_t max_recorded;
+  bool truncated;
+  // Запись кусками по RECORD_CHUNK событий: без перевыделения в push
+  static const size_t RECORD_CHUNK = 1 << 16;
+  std::vector<std::unique_ptr<SolveEvent[]>> chunks;
+  size_t recorded_count;
+};
+
+/**
+ * Saves a trace as text: a header, the starting puzzle as 81 digits, then one
+ * "place|remove|propagate row col digit" line per event, so traces of
+ * different engines can be compared with diff
+ */
+bool save_trace(const std::string &path, const std::string &engine, const int puzzle[9][9],
+                const std::vector<SolveEvent> &events);
+
+bool load_trace(const std::string &path, std::string &engine, int puzzle[9][9],
+                std::vector<SolveEvent> &events);
@@ -0,0 +1,340 @@
+#include "solverPortfolio.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+// Маршруты по умолчанию, до первого замера portfolioBench. Строки: полосы
+// по числу подсказок, в строке — решается одиночками / заполняют много / застревают.
+// Везде bitmask: на замеренных наборах ни другой решатель, ни гонка его не обгоняли,
+// другой маршрут ставится только по замеру
+PortfolioRoute portfolio_routes[PORTFOLIO_BUCKETS] = {
+    {ENGINE_BITMASK, ENGINE_NONE}, {ENGINE_BITMASK, ENGINE_NONE}, {ENGINE_BITMASK, ENGINE_NONE}, // <= 21
+    {ENGINE_BITMASK, ENGINE_NONE}, {ENGINE_BITMASK, ENGINE_NONE}, {ENGINE_BITMASK, ENGINE_NONE}, // 22-25
+    {ENGINE_BITMASK, ENGINE_NONE}, {ENGINE_BITMASK, ENGINE_NONE}, {ENGINE_BITMASK, ENGINE_NONE}, // 26-30
+    {ENGINE_BITMASK, ENGINE_NONE}, {ENGINE_BITMASK, ENGINE_NONE}, {ENGINE_BITMASK, ENGINE_NONE}, // 31-40
+    {ENGINE_BITMASK, ENGINE_NONE}, {ENGINE_BITMASK, ENGINE_NONE}, {ENGINE_BITMASK, ENGINE_NONE}, // >= 41
+};
+std::string portfolio_routes_path = "portfolio_routes.txt";
+
+static const int CLUE_BAND_LIMITS[PORTFOLIO_CLUE_BANDS - 1] = {21, 25, 30, 40};
+static const char *CLUE_BAND_NAMES[PORTFOLIO_CLUE_BANDS] = {"<=21 clues", "22-25 clues", "26-30 clues",
+                                                            "31-40 clues", ">=41 clues"};
+static const char *SINGLE_CLASS_NAMES[PORTFOLIO_SINGLE_CLASSES] = {"singles solve", "singles fill many",
+                                                                   "singles stall"};
+static const char *ENGINE_NAMES[ENGINE_COUNT] = {"backtracking", "bitmask", "logic"};
+
+const char *engine_name(int engine)
+{
+  return engine >= 0 && engine < ENGINE_COUNT ? ENGINE_NAMES[engine] : "-";
+}
+
+static int engine_by_name(const std::string &name)
+{
+  for (int engine = 0; engine < ENGINE_COUNT; engine++)
+  {
+    if (name == ENGINE_NAMES[engine])
+    {
+      return engine;
+    }
+  }
+  return ENGINE_NONE;
+}
+
+std::string bucket_name(int bucket)
+{
+  return std::string(CLUE_BAND_NAMES[bucket / PORTFOLIO_SINGLE_CLASSES]) + ", " +
+         SINGLE_CLASS_NAMES[bucket % PORTFOLIO_SINGLE_CLASSES];
+}
+
+void extract_features(const int puzzle[9][9], PuzzleFeatures &features)
+{
+  features = PuzzleFeatures();
+  unsigned short rows[9] = {}, cols[9] = {}, boxes[9] = {};
+  int values[81];
+  for (int cell = 0; cell < 81; cell++)
+  {
+    int row = cell / 9, col = cell % 9, box = row / 3 * 3 + col / 3;
+    values[cell] = puzzle[row][col];
+    if (values[cell] == 0)
+    {
+      continue;
+    }
+    unsigned short bit = 1 << values[cell];
+    features.clues++;
+    features.conflict = features.conflict || ((rows[row] | cols[col] | boxes[box]) & bit);
+    rows[row] |= bit;
+    cols[col] |= bit;
+    boxes[box] |= bit;
+  }
+
+  int empty = 81 - features.clues;
+  int candidates = 0;
+  for (int cell = 0; cell < 81; cell++)
+  {
+    int row = cell / 9, col = cell % 9;
+    if (values[cell] == 0)
+    {
+      int count = __builtin_popcount(~(rows[row] | cols[col] | boxes[row / 3 * 3 + col / 3]) & 0x3FE);
+      features.candidate_counts[count]++;
+      candidates += count;
+    }
+  }
+  features.mean_candidates = empty > 0 ? (double)candidates / empty : 0;
+
+  // Голые одиночки до остановки: сколько клеток решается без перебора
+  bool progress = !features.conflict;
+  while (progress)
+  {
+    progress = false;
+    for (int cell = 0; cell < 81; cell++)
+    {
+      int row = cell / 9, col = cell % 9, box = row / 3 * 3 + col / 3;
+      if (values[cell] != 0)
+      {
+        continue;
+      }
+      unsigned short mask = ~(rows[row] | cols[col] | boxes[box]) & 0x3FE;
+      if (mask == 0)
+      {
+        progress = false; // противоречие: дальше одиночки ничего не скажут
+        break;
+      }
+      if ((mask & (mask - 1)) == 0)
+      {
+        values[cell] = __builtin_ctz(mask);
+        rows[row] |= mask;
+        cols[col] |= mask;
+        boxes[box] |= mask;
+        features.single_yield++;
+        progress = true;
+      }
+    }
+  }
+  features.singles_solve = !features.conflict && features.single_yield == empty;
+
+  int band = 0;
+  while (band < PORTFOLIO_CLUE_BANDS - 1 && features.clues > CLUE_BAND_LIMITS[band])
+  {
+    band++;
+  }
+  int single_class = features.singles_solve ? 0 : features.single_yield * 2 >= empty ? 1 : 2;
+  features.bucket = band * PORTFOLIO_SINGLE_CLASSES + single_class;
+}
+
+// Формат: <номер корзины> <основной решатель> <соперник или -> [# описание]
+bool load_portfolio_routes(const std::string &path)
+{
+  std::ifstream file(path);
+  if (!file)
+  {
+    return false;
+  }
+  std::string line;
+  while (std::getline(file, line))
+  {
+    std::istringstream fields(line);
+    int bucket;
+    std::string primary, secondary;
+    if (line.empty() || line[0] == '#' || !(fields >> bucket >> primary >> secondary))
+    {
+      continue;
+    }
+    if (bucket >= 0 && bucket < PORTFOLIO_BUCKETS && engine_by_name(primary) != ENGINE_NONE)
+    {
+      portfolio_routes[bucket] = {engine_by_name(primary), engine_by_name(secondary)};
+    }
+  }
+  return true;
+}
+
+bool save_portfolio_routes(const std::string &path)
+{
+  std::ofstream file(path, std::ios::trunc);
+  for (int bucket = 0; bucket < PORTFOLIO_BUCKETS; bucket++)
+  {
+    file << bucket << " " << engine_name(portfolio_routes[bucket].primary) << " "
+         << engine_name(portfolio_routes[bucket].secondary) << " # " << bucket_name(bucket) << "\n";
+  }
+  return (bool)file;
+}
+
+PortfolioSolver::PortfolioSolver() : logic_cancelled(false), cancel_requested(false), last_winner(ENGINE_NONE)
+{
+  last_features = PuzzleFeatures();
+}
+
+bool PortfolioSolver::solve(const int puzzle[9][9], int solution[9][9])
+{
+  extract_features(puzzle, last_features);
+  if (last_features.conflict)
+  {
+    last_winner = ENGINE_NONE;
+    return false;
+  }
+  return solve_with(portfolio_routes[last_features.bucket], puzzle, solution);
+}
+
+void PortfolioSolver::load_engine(int engine, const int puzzle[9][9])
+{
+  switch (engine)
+  {
+  case ENGINE_BACKTRACKING:
+    backtracking.load(puzzle);
+    break;
+  case ENGINE_BITMASK:
+    bitmask.load(puzzle);
+    break;
+  case ENGINE_LOGIC:
+    logic_cancelled = false;
+    break;
+  }
+}
+
+bool PortfolioSolver::run_engine(int engine, const int puzzle[9][9])
+{
+  switch (engine)
+  {
+  case ENGINE_BACKTRACKING:
+    return backtracking.solve();
+  case ENGINE_BITMASK:
+    return bitmask.solve();
+  case ENGINE_LOGIC:
+  {
+    hints.sync(puzzle);
+    while (!logic_cancelled && hints.next_hint(hint))
+    {
+      if (hint.technique == Hint::CONTRADICTION)
+      {
+        return false;
+      }
+      hints.apply(hint);
+    }
+    int board[9][9];
+    for (int cell = 0; cell < 81; cell++)
+    {
+      board[cell / 9][cell % 9] = hints.state().values[cell];
+    }
+    // load() снимает отмену, поэтому флаг логики проверяется и после него
+    return !logic_cancelled && logic_search.load(board) && !logic_cancelled && logic_search.solve();
+  }
+  }
+  return false;
+}
+
+const int (*PortfolioSolver::engine_board(int engine) const)[9]
+{
+  switch (engine)
+  {
+  case ENGINE_BACKTRACKING:
+    return backtracking.board;
+  case ENGINE_BITMASK:
+    return bitmask.board;
+  default:
+    return logic_search.board;
+  }
+}
+
+void PortfolioSolver::cancel_engine(int engine)
+{
+  switch (engine)
+  {
+  case ENGINE_BACKTRACKING:
+    backtracking.cancel();
+    break;
+  case ENGINE_BITMASK:
+    bitmask.cancel();
+    break;
+  case ENGINE_LOGIC:
+    logic_cancelled = true;
+    logic_search.cancel();
+    break;
+  }
+}
+
+bool PortfolioSolver::engine_stopped(int engine) const
+{
+  switch (engine)
+  {
+  case ENGINE_BACKTRACKING:
+    return cancel_requested || backtracking.cancelled();
+  case ENGINE_BITMASK:
+    return cancel_requested || bitmask.cancelled();
+  default:
+    return cancel_requested || logic_cancelled;
+  }
+}
+
+void PortfolioSolver::cancel()
+{
+  cancel_requested = true;
+  for (int engine = 0; engine < ENGINE_COUNT; engine++)
+  {
+    cancel_engine(engine);
+  }
+}
+
+bool PortfolioSolver::solve_with(const PortfolioRoute &route, const int puzzle[9][9], int solution[9][9])
+{
+  last_winner = ENGINE_NONE;
+  cancel_requested = false;
+  if (!is_valid_board(puzzle))
+  {
+    return false;
+  }
+
+  if (route.secondary == ENGINE_NONE || route.secondary == route.primary)
+  {
+    load_engine(route.primary, puzzle);
+    // load() снимает отмену движка: cancel(), пришедший до загрузки, ставится заново
+    if (cancel_requested)
+    {
+      cancel_engine(route.primary);
+    }
+    bool solved = run_engine(route.primary, puzzle);
+    if (!solved && engine_stopped(route.primary))
+    {
+      return false;
+    }
+    last_winner = route.primary; // also when the engine proved there is no solution
+    if (!solved)
+    {
+      return false;
+    }
+    std::copy(&engine_board(route.primary)[0][0], &engine_board(route.primary)[0][0] + 81, &solution[0][0]);
+    return true;
+  }
+
+  // Гонка: оба решателя загружаются до старта, чтобы отмена победителем не
+  // потерялась в load() соперника. Первый, кто закончил не по отмене, забирает
+  // результат (решение или его отсутствие) и отменяет другого.
+  load_engine(route.primary, puzzle);
+  load_engine(route.secondary, puzzle);
+  if (cancel_requested)
+  {
+    cancel_engine(route.primary);
+    cancel_engine(route.secondary);
+  }
+  std::atomic<int> winner(ENGINE_NONE);
+  bool outcome = false;
+  auto finish = [&](int engine, int other, bool solved) {
+    int expected = ENGINE_NONE;
+    if ((solved || !engine_stopped(engine)) && winner.compare_exchange_strong(expected, engine))
+    {
+      outcome = solved;
+      cancel_engine(other);
+    }
+  };
+
+  std::thread rival([&] { finish(route.secondary, route.primary, run_engine(route.secondary, puzzle)); });
+  finish(route.primary, route.secondary, run_engine(route.primary, puzzle));
+  rival.join();
+
+  last_winner = winner;
+  if (last_winner == ENGINE_NONE || !outcome)
+  {
+    return false;
+  }
+  std::copy(&engine_board(last_winner)[0][0], &engine_board(last_winner)[0][0] + 81, &solution[0][0]);
+  return true;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+// Портфель решателей: по дешёвым признакам головоломки (число подсказок,
+// распределение кандидатов, сколько клеток заполняют одиночки) выбирается
+// решатель, который на таких головоломках обычно быстрее всех, или два
+// решателя запускаются наперегонки в двух потоках. Таблица маршрутов
+// подбирается по замерам (portfolioBench) и читается из файла.
+//
+// Пока портфелем пользуется только portfolioBench: GUI, libsudoku, batchScan
+// и shardSolve решают напрямую, потому что на замеренных наборах подсчёт
+// признаков не окупался. Подключать стоит после замера, который покажет
+// выигрыш маршрутов над одним bitmask.
+
+#include <atomic>
+#include <string>
+#include "sudokuEngine.h"
+#include "sudokuHints.h"
+
+enum PortfolioEngine
+{
+  ENGINE_NONE = -1,
+  ENGINE_BACKTRACKING = 0, // BacktrackingSolver: для почти заполненных досок
+  ENGINE_BITMASK,          // BitmaskSolver: перебор с выбором клетки с наименьшим числом кандидатов
+  ENGINE_LOGIC,            // логические приёмы HintEngine, остаток — BitmaskSolver
+  ENGINE_COUNT
+};
+
+const char *engine_name(int engine);
+
+/**
+ * Cheap description of a puzzle, a few microseconds to compute
+ */
+struct PuzzleFeatures
+{
+  int clues;
+  bool conflict;          // givens repeat in a row, column or box
+  int candidate_counts[10]; // empty cells by number of candidates
+  double mean_candidates;
+  int single_yield;       // cells filled by naked singles before they stall
+  bool singles_solve;     // naked singles alone fill the grid
+  int bucket;             // row of the routing table
+};
+
+// Таблица маршрутов: полосы по числу подсказок x класс по одиночкам
+static const int PORTFOLIO_CLUE_BANDS = 5;
+static const int PORTFOLIO_SINGLE_CLASSES = 3; // решается одиночками / заполняют много / застревают сразу
+static const int PORTFOLIO_BUCKETS = PORTFOLIO_CLUE_BANDS * PORTFOLIO_SINGLE_CLASSES;
+
+struct PortfolioRoute
+{
+  int primary;   // PortfolioEngine
+  int secondary; // ENGINE_NONE: без гонки
+};
+
+extern PortfolioRoute portfolio_routes[PORTFOLIO_BUCKETS];
+extern std::string portfolio_routes_path;
+
+void extract_features(const int puzzle[9][9], PuzzleFeatures &features);
+
+/**
+ * Reads the routing table written by portfolioBench; buckets missing from
+ * the file keep their defaults
+ */
+bool load_portfolio_routes(const std::string &path);
+bool save_portfolio_routes(const std::string &path);
+
+/**
+ * Human-readable bucket description, e.g. "22-25 clues, singles fill many"
+ */
+std::string bucket_name(int bucket);
+
+class PortfolioSolver
+{
+public:
+  PortfolioSolver();
+
+  /**
+   * Solves with the engine (or the race) the routing table picks for the
+   * puzzle's bucket
+   * @return true if a solution was written, false if none exists or solving was cancelled
+   */
+  bool solve(const int puzzle[9][9], int solution[9][9]);
+
+  /**
+   * Bypasses routing: one engine, or a race when secondary != ENGINE_NONE
+   */
+  bool solve_with(const PortfolioRoute &route, const int puzzle[9][9], int solution[9][9]);
+
+  /**
+   * Stops the running solve from any thread, also while it is still loading
+   * its engines; a cancel between two solves does not carry over
+   */
+  void cancel();
+
+  const PuzzleFeatures &features() const { return last_features; }
+  /**
+   * Engine whose answer the last solve returned, ENGINE_NONE if it was cancelled
+   * or the givens conflict
+   */
+  int winner() const { return last_winner; }
+
+private:
+  bool run_engine(int engine, const int puzzle[9][9]);
+  void load_engine(int engine, const int puzzle[9][9]);
+  const int (*engine_board(int engine) const)[9];
+  void cancel_engine(int engine);
+  bool engine_stopped(int engine) const; // cancelled rather than finished
+
+  BacktrackingSolver backtracking;
+  BitmaskSolver bitmask;
+  HintEngine hints;
+  Hint hint;
+  BitmaskSolver logic_search; // перебор после логики: отдельный, чтобы гонка bitmask/logic не делила состояние
+  std::atomic<bool> logic_cancelled;
+  std::atomic<bool> cancel_requested;
+
+  PuzzleFeatures last_features;
+  int last_winner;
+};
@@ -0,0 +1,255 @@
+#include "sudokuBoard.h"
+#include "pipelineTrace.h"
+#include <FL/Fl.H>
+#include <FL/fl_draw.H>
+#include <cstring>
+
+// Line widths between cells and between 3x3 boxes
+static const int THIN_LINE = 1;
+static const int THICK_LINE = 3;
+
+SudokuBoard::SudokuBoard(int x, int y, int w, int h)
+    : Fl_Widget(x, y, w, h), selected(-1)
+{
+  clear();
+}
+
+void SudokuBoard::value(int row, int col, int digit)
+{
+  int index = row * 9 + col;
+  if (values[index] != digit)
+  {
+    values[index] = digit;
+    damage_cell(index);
+  }
+}
+
+void SudokuBoard::style(int row, int col, CellStyle style)
+{
+  int index = row * 9 + col;
+  if (styles[index] != style)
+  {
+    styles[index] = style;
+    damage_cell(index);
+  }
+}
+
+void SudokuBoard::candidates(int row, int col, unsigned short mask)
+{
+  int index = row * 9 + col;
+  if (marks[index] != mask)
+  {
+    marks[index] = mask;
+    damage_cell(index);
+  }
+}
+
+void SudokuBoard::clear()
+{
+  memset(values, 0, sizeof(values));
+  memset(styles, STYLE_NORMAL, sizeof(styles));
+  memset(marks, 0, sizeof(marks));
+  memset(dirty, 0, sizeof(dirty));
+  redraw();
+}
+
+void SudokuBoard::damage_cell(int index)
+{
+  dirty[index] = true;
+  damage(FL_DAMAGE_USER1);
+}
+
+/**
+ * Inner rectangle of a cell, excluding the grid lines around it
+ */
+void SudokuBoard::cell_box(int index, int &cx, int &cy, int &cw, int &ch) const
+{
+  int row = index / 9;
+  int col = index % 9;
+  int x0 = x() + col * w() / 9;
+  int x1 = x() + (col + 1) * w() / 9;
+  int y0 = y() + row * h() / 9;
+  int y1 = y() + (row + 1) * h() / 9;
+
+  int left = (col % 3 == 0) ? THICK_LINE : THIN_LINE;
+  int top = (row % 3 == 0) ? THICK_LINE : THIN_LINE;
+  int right = (col == 8) ? THICK_LINE : 0;
+  int bottom = (row == 8) ? THICK_LINE : 0;
+
+  cx = x0 + left;
+  cy = y0 + top;
+  cw = x1 - x0 - left - right;
+  ch = y1 - y0 - top - bottom;
+}
+
+int SudokuBoard::cell_at(int ex, int ey) const
+{
+  int col = (ex - x()) * 9 / w();
+  int row = (ey - y()) * 9 / h();
+  if (row < 0 || row > 8 || col < 0 || col > 8)
+  {
+    return -1;
+  }
+  return row * 9 + col;
+}
+
+void SudokuBoard::draw_cell(int index)
+{
+  int cx, cy, cw, ch;
+  cell_box(index, cx, cy, cw, ch);
+
+  int row = index / 9;
+  int col = index % 9;
+  Fl_Color background = (((row / 3) + (col / 3)) % 2) ? fl_rgb_color(230, 230, 230) : FL_WHITE;
+  switch (styles[index])
+  {
+  case STYLE_SOLVED:
+    background = FL_GREEN;
+    break;
+  case STYLE_UNCERTAIN:
+    background = FL_YELLOW;
+    break;
+  case STYLE_HIGHLIGHT:
+    background = fl_rgb_color(255, 200, 120);
+    break;
+  }
+  if (index == selected)
+  {
+    background = fl_rgb_color(170, 200, 255);
+  }
+
+  fl_color(background);
+  fl_rectf(cx, cy, cw, ch);
+
+  if (values[index] != 0)
+  {
+    char label[2] = {(char)('0' + values[index]), 0};
+    fl_color(FL_BLACK);
+    fl_font(styles[index] == STYLE_GIVEN ? FL_HELVETICA_BOLD : FL_HELVETICA, ch * 3 / 5);
+    fl_draw(label, cx, cy, cw, ch, FL_ALIGN_CENTER);
+  }
+  else if (marks[index] != 0)
+  {
+    // Pencil marks in a 3x3 layout inside the cell
+    fl_color(FL_DARK3);
+    fl_font(FL_HELVETICA, ch / 4);
+    for (int digit = 1; digit <= 9; digit++)
+    {
+      if (marks[index] & (1 << digit))
+      {
+        char label[2] = {(char)('0' + digit), 0};
+        int mx = cx + (digit - 1) % 3 * cw / 3;
+        int my = cy + (digit - 1) / 3 * ch / 3;
+        fl_draw(label, mx, my, cw / 3, ch / 3, FL_ALIGN_CENTER);
+      }
+    }
+  }
+  dirty[index] = false;
+}
+
+void SudokuBoard::draw()
+{
+  TRACE_SCOPE(STAGE_DISPLAY);
+  if (damage() & FL_DAMAGE_ALL)
+  {
+    // Full redraw: grid lines first, then every cell inside them
+    fl_color(FL_BLACK);
+    fl_rectf(x(), y(), w(), h());
+    for (int index = 0; index < 81; index++)
+    {
+      draw_cell(index);
+    }
+    return;
+  }
+
+  // Partial redraw: only the cells whose state changed
+  for (int index = 0; index < 81; index++)
+  {
+    if (dirty[index])
+    {
+      draw_cell(index);
+    }
+  }
+}
+
+void SudokuBoard::select(int index)
+{
+  if (index == selected)
+  {
+    return;
+  }
+  if (selected >= 0)
+  {
+    damage_cell(selected);
+  }
+  selected = index;
+  if (selected >= 0)
+  {
+    damage_cell(selected);
+  }
+}
+
+int SudokuBoard::handle(int event)
+{
+  switch (event)
+  {
+  case FL_PUSH:
+    take_focus();
+    select(cell_at(Fl::event_x(), Fl::event_y()));
+    return 1;
+
+  case FL_FOCUS:
+    return 1;
+
+  case FL_UNFOCUS:
+    select(-1);
+    return 1;
+
+  case FL_KEYBOARD:
+  {
+    if (selected < 0)
+    {
+      return 0;
+    }
+    int row = selected / 9;
+    int col = selected % 9;
+    int key = Fl::event_key();
+
+    if (key == FL_Left || key == FL_Right || key == FL_Up || key == FL_Down)
+    {
+      if (key == FL_Left)
+        col = (col + 8) % 9;
+      if (key == FL_Right)
+        col = (col + 1) % 9;
+      if (key == FL_Up)
+        row = (row + 8) % 9;
+      if (key == FL_Down)
+        row = (row + 1) % 9;
+      select(row * 9 + col);
+      return 1;
+    }
+
+    const char *text = Fl::event_text();
+    int digit = -1;
+    if (text && text[0] >= '0' && text[0] <= '9')
+    {
+      digit = text[0] - '0';
+    }
+    else if (key == FL_BackSpace || key == FL_Delete || (text && text[0] == ' '))
+    {
+      digit = 0;
+    }
+    if (digit < 0)
+    {
+      return 0;
+    }
+
+    // Typed values are user input again, whatever the cell showed before
+    value(row, col, digit);
+    style(row, col, STYLE_NORMAL);
+    do_callback();
+    return 1;
+  }
+  }
+  return Fl_Widget::handle(event);
+}
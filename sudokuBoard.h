@@ -0,0 +1,57 @@
+#pragma once
+
+#include <FL/Fl_Widget.H>
+
+/**
+ * Single widget that draws the whole 9x9 board from compact state arrays.
+ * Setters only mark the touched cells as damaged, so redraws are limited
+ * to the cells that actually changed. Digits are typed directly:
+ * arrows move the selection, 1-9 set a cell, 0/Backspace/Delete clear it.
+ */
+class SudokuBoard : public Fl_Widget
+{
+public:
+  enum CellStyle
+  {
+    STYLE_NORMAL = 0, // user input or empty
+    STYLE_GIVEN,      // clue of the puzzle being solved
+    STYLE_SOLVED,     // filled in by the solver
+    STYLE_UNCERTAIN,  // scanned with low confidence
+    STYLE_HIGHLIGHT   // hint or visualization focus
+  };
+
+  SudokuBoard(int x, int y, int w, int h);
+
+  int value(int row, int col) const { return values[row * 9 + col]; }
+  void value(int row, int col, int digit);
+
+  CellStyle style(int row, int col) const { return (CellStyle)styles[row * 9 + col]; }
+  void style(int row, int col, CellStyle style);
+
+  /**
+   * Pencil marks for an empty cell: bit d set means digit d is a candidate
+   */
+  unsigned short candidates(int row, int col) const { return marks[row * 9 + col]; }
+  void candidates(int row, int col, unsigned short mask);
+
+  /**
+   * Empties every cell, style and pencil mark
+   */
+  void clear();
+
+  void draw() override;
+  int handle(int event) override;
+
+private:
+  void damage_cell(int index);
+  void draw_cell(int index);
+  void cell_box(int index, int &cx, int &cy, int &cw, int &ch) const;
+  int cell_at(int ex, int ey) const;
+  void select(int index);
+
+  unsigned char values[81];
+  unsigned char styles[81];
+  unsigned short marks[81];
+  bool dirty[81];
+  int selected; // -1 when nothing is selected
+};
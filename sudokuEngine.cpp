@@ -0,0 +1,654 @@
+#include "sudokuEngine.h"
+#include <algorithm>
+
+// How many nodes to visit between looks at the clock for progress reports
+static const long long PROGRESS_CHECK_NODES = 1 << 14;
+
+bool parse_puzzle(const std::string &text, int puzzle[9][9])
+{
+  int cell = 0;
+  for (char c : text)
+  {
+    if (cell == 81)
+    {
+      break;
+    }
+    if (c == '.')
+    {
+      c = '0';
+    }
+    if (c >= '0' && c <= '9')
+    {
+      puzzle[cell / 9][cell % 9] = c - '0';
+      cell++;
+    }
+  }
+  return cell == 81;
+}
+
+bool is_valid_board(const int board[9][9])
+{
+  // Check rows
+  for (int row = 0; row < 9; row++)
+  {
+    bool used[10] = {false}; // Track digits 1-9
+    for (int col = 0; col < 9; col++)
+    {
+      int num = board[row][col];
+      if (num != 0)
+      {
+        if (used[num])
+          return false; // Duplicate found
+        used[num] = true;
+      }
+    }
+  }
+
+  // Check columns
+  for (int col = 0; col < 9; col++)
+  {
+    bool used[10] = {false};
+    for (int row = 0; row < 9; row++)
+    {
+      int num = board[row][col];
+      if (num != 0)
+      {
+        if (used[num])
+          return false;
+        used[num] = true;
+      }
+    }
+  }
+
+  // Check 3x3 boxes
+  for (int box_row = 0; box_row < 3; box_row++)
+  {
+    for (int box_col = 0; box_col < 3; box_col++)
+    {
+      bool used[10] = {false};
+      for (int row = box_row * 3; row < box_row * 3 + 3; row++)
+      {
+        for (int col = box_col * 3; col < box_col * 3 + 3; col++)
+        {
+          int num = board[row][col];
+          if (num != 0)
+          {
+            if (used[num])
+              return false;
+            used[num] = true;
+          }
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+BacktrackingSolver::BacktrackingSolver()
+    : node_count(0), cancel_requested(false), trace(nullptr), progress_interval(100)
+{
+  for (int i = 0; i < 9; i++)
+  {
+    for (int j = 0; j < 9; j++)
+    {
+      board[i][j] = 0;
+    }
+  }
+}
+
+void BacktrackingSolver::load(const int puzzle[9][9])
+{
+  // Reset here rather than in solve(): a cancel that arrives before the
+  // solving thread starts must not be lost
+  cancel_requested.store(false, std::memory_order_relaxed);
+  for (int i = 0; i < 9; i++)
+  {
+    for (int j = 0; j < 9; j++)
+    {
+      board[i][j] = puzzle[i][j];
+    }
+  }
+}
+
+void BacktrackingSolver::set_progress_callback(ProgressCallback callback, std::chrono::milliseconds interval)
+{
+  progress = callback;
+  progress_interval = interval;
+}
+
+bool BacktrackingSolver::solve()
+{
+  node_count = 0;
+  started = last_report = std::chrono::steady_clock::now();
+
+  bool solved = solve_backtracking(0, 0);
+  if (progress)
+  {
+    progress(node_count, std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+  }
+  return solved && !cancelled();
+}
+
+void BacktrackingSolver::report_progress()
+{
+  auto now = std::chrono::steady_clock::now();
+  if (now - last_report >= progress_interval)
+  {
+    last_report = now;
+    progress(node_count, std::chrono::duration<double>(now - started).count());
+  }
+}
+
+/**
+ * Backtracking algorithm to solve the Sudoku puzzle
+ * @param row Current row being processed
+ * @param col Current column being processed
+ * @return true if solution found, false otherwise
+ */
+bool BacktrackingSolver::solve_backtracking(int row, int col)
+{
+  // Base case: if we've processed all rows, solution is complete
+  if (row == 9)
+  {
+    return true;
+  }
+
+  // Move to next row when we reach the end of current row
+  if (col == 9)
+  {
+    return solve_backtracking(row + 1, 0);
+  }
+
+  // If cell is already filled, move to next cell
+  if (board[row][col] != 0)
+  {
+    return solve_backtracking(row, col + 1);
+  }
+
+  if (cancelled())
+  {
+    return false;
+  }
+  if (++node_count % PROGRESS_CHECK_NODES == 0 && progress)
+  {
+    report_progress();
+  }
+
+  // Try digits 1-9 for empty cell
+  for (int num = 1; num <= 9; num++)
+  {
+    if (is_safe(row, col, num))
+    {
+      board[row][col] = num; // Place number
+      if (trace)
+        trace->push(EVENT_PLACE, row * 9 + col, num);
+
+      // Recursively solve remaining cells
+      if (solve_backtracking(row, col + 1))
+      {
+        return true; // Solution found
+      }
+
+      // Backtrack: remove number and try next
+      board[row][col] = 0;
+      if (trace)
+        trace->push(EVENT_REMOVE, row * 9 + col, num);
+    }
+  }
+
+  return false; // No solution found
+}
+
+/**
+ * Checks if it's safe to place a number at given position
+ * @param row Row index
+ * @param col Column index
+ * @param num Number to place (1-9)
+ * @return true if placement is valid, false otherwise
+ */
+bool BacktrackingSolver::is_safe(int row, int col, int num) const
+{
+  // Check row for conflicts
+  for (int j = 0; j < 9; j++)
+  {
+    if (board[row][j] == num)
+    {
+      return false;
+    }
+  }
+
+  // Check column for conflicts
+  for (int i = 0; i < 9; i++)
+  {
+    if (board[i][col] == num)
+    {
+      return false;
+    }
+  }
+
+  // Check 3x3 box for conflicts
+  int box_start_row = (row / 3) * 3;
+  int box_start_col = (col / 3) * 3;
+  for (int i = box_start_row; i < box_start_row + 3; i++)
+  {
+    for (int j = box_start_col; j < box_start_col + 3; j++)
+    {
+      if (board[i][j] == num)
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+BitmaskSolver::BitmaskSolver()
+    : loaded_valid(false), excluded_cell(-1), excluded_bit(0), solution_limit(1), solutions_found(0), node_count(0),
+      guess_count(0), cancel_requested(false), trace(nullptr)
+{
+  for (int i = 0; i < 9; i++)
+  {
+    for (int j = 0; j < 9; j++)
+    {
+      board[i][j] = 0;
+    }
+  }
+}
+
+bool BitmaskSolver::load(const int puzzle[9][9])
+{
+  cancel_requested.store(false, std::memory_order_relaxed);
+  for (int i = 0; i < 9; i++)
+  {
+    start.rows[i] = start.cols[i] = start.boxes[i] = 0;
+  }
+
+  loaded_valid = true;
+  for (int cell = 0; cell < 81; cell++)
+  {
+    int row = cell / 9;
+    int col = cell % 9;
+    int box = row / 3 * 3 + col / 3;
+    int digit = puzzle[row][col];
+    board[row][col] = digit;
+    start.cells[cell] = 0;
+    if (digit < 0 || digit > 9)
+    {
+      loaded_valid = false;
+      continue;
+    }
+    if (digit == 0)
+    {
+      continue;
+    }
+
+    unsigned short bit = 1 << digit;
+    if ((start.rows[row] | start.cols[col] | start.boxes[box]) & bit)
+    {
+      loaded_valid = false;
+    }
+    start.cells[cell] = digit;
+    start.rows[row] |= bit;
+    start.cols[col] |= bit;
+    start.boxes[box] |= bit;
+  }
+  return loaded_valid;
+}
+
+bool BitmaskSolver::solve()
+{
+  return count_solutions(1) == 1;
+}
+
+int BitmaskSolver::count_solutions(int limit)
+{
+  node_count = 0;
+  guess_count = 0;
+  solutions_found = 0;
+  solution_limit = limit;
+  if (!loaded_valid || limit <= 0)
+  {
+    return 0;
+  }
+
+  State state = start;
+  search(state);
+  return cancelled() ? 0 : solutions_found;
+}
+
+bool BitmaskSolver::set_clue(int cell, int digit)
+{
+  int row = cell / 9;
+  int col = cell % 9;
+  int box = row / 3 * 3 + col / 3;
+  int old_digit = start.cells[cell];
+  if (old_digit != 0)
+  {
+    unsigned short old_bit = 1 << old_digit;
+    start.rows[row] &= ~old_bit;
+    start.cols[col] &= ~old_bit;
+    start.boxes[box] &= ~old_bit;
+  }
+  start.cells[cell] = digit;
+  board[row][col] = digit;
+  if (digit == 0)
+  {
+    return true;
+  }
+
+  unsigned short bit = 1 << digit;
+  bool fits = !((start.rows[row] | start.cols[col] | start.boxes[box]) & bit);
+  start.rows[row] |= bit;
+  start.cols[col] |= bit;
+  start.boxes[box] |= bit;
+  loaded_valid = loaded_valid && fits;
+  return fits;
+}
+
+bool BitmaskSolver::clue_is_essential(int cell)
+{
+  int digit = start.cells[cell];
+  if (digit == 0)
+  {
+    return false;
+  }
+
+  set_clue(cell, 0);
+  excluded_cell = cell;
+  excluded_bit = 1 << digit;
+  bool other_solution = count_solutions(1) > 0;
+  excluded_cell = -1;
+  excluded_bit = 0;
+  set_clue(cell, digit);
+  return other_solution;
+}
+
+void BitmaskSolver::search(State &state)
+{
+  if (cancelled())
+  {
+    return;
+  }
+
+  // Pick the empty cell with the fewest candidates
+  int best_cell = -1;
+  int best_count = 10;
+  unsigned short best_mask = 0;
+  for (int cell = 0; cell < 81; cell++)
+  {
+    if (state.cells[cell] != 0)
+    {
+      continue;
+    }
+    int row = cell / 9;
+    int col = cell % 9;
+    unsigned short mask = ~(state.rows[row] | state.cols[col] | state.boxes[row / 3 * 3 + col / 3]) & 0x3FE;
+    if (cell == excluded_cell)
+    {
+      mask &= ~excluded_bit;
+    }
+    int count = __builtin_popcount(mask);
+    if (count < best_count)
+    {
+      best_cell = cell;
+      best_count = count;
+      best_mask = mask;
+      if (count <= 1)
+      {
+        break;
+      }
+    }
+  }
+
+  if (best_cell < 0)
+  {
+    // No empty cells left: a solution
+    if (solutions_found++ == 0)
+    {
+      for (int cell = 0; cell < 81; cell++)
+      {
+        board[cell / 9][cell % 9] = state.cells[cell];
+      }
+    }
+    return;
+  }
+  if (best_count > 1)
+  {
+    guess_count++;
+  }
+
+  int row = best_cell / 9;
+  int col = best_cell % 9;
+  int box = row / 3 * 3 + col / 3;
+  while (best_mask != 0 && solutions_found < solution_limit)
+  {
+    int digit = __builtin_ctz(best_mask);
+    unsigned short bit = 1 << digit;
+    best_mask &= best_mask - 1;
+    node_count++;
+
+    state.cells[best_cell] = digit;
+    state.rows[row] |= bit;
+    state.cols[col] |= bit;
+    state.boxes[box] |= bit;
+    if (trace)
+      trace->push(best_count == 1 ? EVENT_PROPAGATE : EVENT_PLACE, best_cell, digit);
+    search(state);
+    state.rows[row] &= ~bit;
+    state.cols[col] &= ~bit;
+    state.boxes[box] &= ~bit;
+    // После найденного решения журнал заканчивается на решённой доске
+    if (trace && solutions_found < solution_limit)
+      trace->push(EVENT_REMOVE, best_cell, digit);
+  }
+  state.cells[best_cell] = 0;
+}
+
+SolutionEnumerator::SolutionEnumerator()
+    : depth(0), valid(false), started(false), finished(true), random_seed(0), random_state(0), produced_count(0),
+      node_count(0), earlier_nodes(0), cancel_requested(false)
+{
+}
+
+bool SolutionEnumerator::load(const int puzzle[9][9])
+{
+  cancel_requested.store(false, std::memory_order_relaxed);
+  std::copy(&puzzle[0][0], &puzzle[0][0] + 81, &givens[0][0]);
+  for (int i = 0; i < 9; i++)
+  {
+    rows[i] = cols[i] = boxes[i] = 0;
+  }
+  depth = 0;
+  started = false;
+  produced_count = 0;
+  earlier_nodes += node_count;
+  node_count = 0;
+  valid = true;
+  for (int cell = 0; cell < 81; cell++)
+  {
+    int digit = puzzle[cell / 9][cell % 9];
+    cells[cell] = 0;
+    if (digit < 0 || digit > 9)
+    {
+      valid = false;
+    }
+    else if (digit != 0)
+    {
+      int row = cell / 9;
+      int col = cell % 9;
+      if ((rows[row] | cols[col] | boxes[row / 3 * 3 + col / 3]) & (1 << digit))
+      {
+        valid = false;
+      }
+      place(cell, digit);
+    }
+  }
+  finished = !valid;
+  return valid;
+}
+
+void SolutionEnumerator::place(int cell, int digit)
+{
+  int row = cell / 9;
+  int col = cell % 9;
+  cells[cell] = digit;
+  rows[row] |= 1 << digit;
+  cols[col] |= 1 << digit;
+  boxes[row / 3 * 3 + col / 3] |= 1 << digit;
+}
+
+void SolutionEnumerator::unplace(int cell, int digit)
+{
+  int row = cell / 9;
+  int col = cell % 9;
+  cells[cell] = 0;
+  rows[row] &= ~(1 << digit);
+  cols[col] &= ~(1 << digit);
+  boxes[row / 3 * 3 + col / 3] &= ~(1 << digit);
+}
+
+int SolutionEnumerator::take_digit(uint16_t &remaining)
+{
+  int digit;
+  if (random_seed == 0)
+  {
+    digit = __builtin_ctz(remaining);
+  }
+  else
+  {
+    // xorshift64*, then the k-th remaining digit
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    int k = (int)((random_state * 2685821657736338717ULL >> 32) % __builtin_popcount(remaining));
+    uint16_t mask = remaining;
+    while (k-- > 0)
+    {
+      mask &= mask - 1;
+    }
+    digit = __builtin_ctz(mask);
+  }
+  remaining &= ~(1 << digit);
+  return digit;
+}
+
+/**
+ * Runs the search up to the next solution; the board state is left as that
+ * solution and the next call backtracks out of it
+ */
+bool SolutionEnumerator::advance()
+{
+  if (finished)
+  {
+    return false;
+  }
+  bool descend = !started;
+  started = true;
+
+  while (true)
+  {
+    if (cancelled())
+    {
+      finished = true;
+      return false;
+    }
+
+    if (descend)
+    {
+      // Branch on the empty cell with the fewest candidates
+      int best_cell = -1;
+      int best_count = 10;
+      uint16_t best_mask = 0;
+      for (int cell = 0; cell < 81 && best_count > 1; cell++)
+      {
+        if (cells[cell] != 0)
+        {
+          continue;
+        }
+        int row = cell / 9;
+        int col = cell % 9;
+        uint16_t mask = ~(rows[row] | cols[col] | boxes[row / 3 * 3 + col / 3]) & 0x3FE;
+        int count = __builtin_popcount(mask);
+        if (count < best_count)
+        {
+          best_cell = cell;
+          best_count = count;
+          best_mask = mask;
+        }
+      }
+
+      if (best_cell < 0)
+      {
+        produced_count++;
+        return true;
+      }
+      if (best_mask != 0)
+      {
+        Frame frame = {(uint8_t)best_cell, 0, best_mask};
+        stack[depth++] = frame;
+      }
+    }
+
+    // Next digit for the innermost open cell, popping exhausted ones
+    if (depth == 0)
+    {
+      finished = true;
+      return false;
+    }
+    Frame &frame = stack[depth - 1];
+    if (frame.digit != 0)
+    {
+      unplace(frame.cell, frame.digit);
+      frame.digit = 0;
+    }
+    if (frame.remaining == 0)
+    {
+      depth--;
+      descend = false;
+      continue;
+    }
+    frame.digit = take_digit(frame.remaining);
+    place(frame.cell, frame.digit);
+    node_count++;
+    descend = true;
+  }
+}
+
+bool SolutionEnumerator::next(int solution[9][9])
+{
+  if (!advance())
+  {
+    return false;
+  }
+  for (int cell = 0; cell < 81; cell++)
+  {
+    solution[cell / 9][cell % 9] = cells[cell];
+  }
+  return true;
+}
+
+bool SolutionEnumerator::sample(int solution[9][9])
+{
+  if (random_seed == 0)
+  {
+    set_random_order(1);
+  }
+  // load() keeps the generator running, so every restart takes a new path
+  if (!load(givens))
+  {
+    return false;
+  }
+  return next(solution);
+}
+
+long long SolutionEnumerator::skip(long long count)
+{
+  long long skipped = 0;
+  while (skipped < count && advance())
+  {
+    skipped++;
+  }
+  return skipped;
+}
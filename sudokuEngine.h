@@ -0,0 +1,254 @@
+#pragma once
+
+// Решатель судоку без GUI: тот же перебор с возвратом, что был в SudokuGUI,
+// плюс счётчик узлов, отмена из другого потока и отчёт о прогрессе.
+// BitmaskSolver — быстрый перебор на битовых масках для подсчёта решений
+// и пакетной работы (libsudoku), SolutionEnumerator — ленивый перебор всех решений.
+
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include <string>
+#include "solveTrace.h"
+
+/**
+ * Validates that a board configuration is legal
+ * Checks for duplicate numbers in rows, columns, and 3x3 boxes
+ */
+bool is_valid_board(const int board[9][9]);
+
+/**
+ * Reads the first 81 cells from text: digits, with '0' or '.' for empty;
+ * anything else (spaces, newlines, separators) is skipped
+ * @return false if the text holds fewer than 81 cells
+ */
+bool parse_puzzle(const std::string &text, int puzzle[9][9]);
+
+class BacktrackingSolver
+{
+public:
+  /**
+   * Called from the solving thread with the node count and elapsed time,
+   * at most once per progress_interval
+   */
+  typedef std::function<void(long long nodes, double seconds)> ProgressCallback;
+
+  BacktrackingSolver();
+
+  /**
+   * Copies the puzzle in (0 means empty) and clears a previous cancel request
+   */
+  void load(const int puzzle[9][9]);
+
+  /**
+   * Solves the loaded puzzle in place
+   * @return true if a solution was found, false if none exists or solving was cancelled
+   */
+  bool solve();
+
+  /**
+   * Requests the running solve() to stop; safe to call from any thread
+   */
+  void cancel() { cancel_requested.store(true, std::memory_order_relaxed); }
+  bool cancelled() const { return cancel_requested.load(std::memory_order_relaxed); }
+
+  void set_progress_callback(ProgressCallback callback, std::chrono::milliseconds interval);
+
+  /**
+   * Records place/remove events of the search; nullptr turns tracing off
+   */
+  void set_trace(SolveTrace *trace) { this->trace = trace; }
+
+  const char *name() const { return "backtracking"; }
+
+  long long nodes() const { return node_count; }
+
+  int board[9][9]; // Current state of the board
+
+private:
+  bool solve_backtracking(int row, int col);
+  bool is_safe(int row, int col, int num) const;
+  void report_progress();
+
+  long long node_count;
+  std::atomic<bool> cancel_requested;
+
+  SolveTrace *trace;
+
+  ProgressCallback progress;
+  std::chrono::milliseconds progress_interval;
+  std::chrono::steady_clock::time_point started;
+  std::chrono::steady_clock::time_point last_report;
+};
+
+/**
+ * Search over row/column/box bitmasks that always branches on the cell with
+ * the fewest candidates. Keeps all state in fixed arrays on the stack, so
+ * solving and counting never allocate.
+ */
+class BitmaskSolver
+{
+public:
+  BitmaskSolver();
+
+  /**
+   * Copies the puzzle in and clears a previous cancel request
+   * @return false if the givens already conflict or a value is out of range
+   */
+  bool load(const int puzzle[9][9]);
+
+  /**
+   * Solves the loaded puzzle into board
+   * @return true if a solution was found, false if none exists or solving was cancelled
+   */
+  bool solve();
+
+  /**
+   * Counts solutions, stopping once limit is reached; board receives the first one
+   */
+  int count_solutions(int limit);
+
+  /**
+   * Changes one clue of the loaded puzzle in place (0 removes it), so checks
+   * that differ by a single clue do not reload the whole board
+   * @return false if the digit conflicts with another clue
+   */
+  bool set_clue(int cell, int digit);
+
+  /**
+   * For a loaded puzzle with a unique solution: whether the clue in cell is
+   * needed, i.e. some solution has another digit there once it is removed.
+   * Searches for one such solution instead of counting to two.
+   */
+  bool clue_is_essential(int cell);
+
+  void cancel() { cancel_requested.store(true, std::memory_order_relaxed); }
+  bool cancelled() const { return cancel_requested.load(std::memory_order_relaxed); }
+
+  /**
+   * Records the search: forced cells (one candidate left) as propagate
+   * events, branches as place, undoing either as remove; nullptr turns
+   * tracing off
+   */
+  void set_trace(SolveTrace *trace) { this->trace = trace; }
+
+  const char *name() const { return "bitmask"; }
+
+  long long nodes() const { return node_count; }
+
+  /**
+   * Branches with more than one candidate (0 means pure forced moves)
+   */
+  long long guesses() const { return guess_count; }
+
+  int board[9][9];
+
+private:
+  struct State
+  {
+    unsigned char cells[81];
+    unsigned short rows[9], cols[9], boxes[9]; // bit d set = digit d used
+  };
+
+  void search(State &state);
+
+  State start;
+  bool loaded_valid;
+  int excluded_cell;             // clue_is_essential: this cell may not take
+  unsigned short excluded_bit;   // its original digit
+  int solution_limit;
+  int solutions_found;
+  long long node_count;
+  long long guess_count;
+  std::atomic<bool> cancel_requested;
+
+  SolveTrace *trace;
+};
+
+/**
+ * Yields the solutions of a puzzle one at a time. The search runs on an
+ * explicit fixed-size stack and pauses after each solution, so memory stays
+ * constant however many solutions there are, and next() resumes where the
+ * previous call stopped.
+ */
+class SolutionEnumerator
+{
+public:
+  SolutionEnumerator();
+
+  /**
+   * Starts a new enumeration (in the current order) and clears a cancel request
+   * @return false if the givens already conflict or a value is out of range
+   */
+  bool load(const int puzzle[9][9]);
+
+  /**
+   * Order of the digits tried at each branch: ascending (seed 0, the default),
+   * or shuffled by a seeded generator for random-order sampling. The generator
+   * keeps running across load() calls; set the seed again to repeat an order.
+   */
+  void set_random_order(uint64_t seed)
+  {
+    random_seed = seed;
+    random_state = seed;
+  }
+
+  /**
+   * Writes the next solution
+   * @return false once all solutions have been produced or on cancel
+   */
+  bool next(int solution[9][9]);
+
+  /**
+   * Steps over up to count solutions without copying them
+   * @return how many were actually skipped
+   */
+  long long skip(long long count);
+
+  /**
+   * Independent random sample: restarts from the givens on a fresh random
+   * path and returns its first solution. Samples may repeat; the lazy
+   * enumeration restarts too.
+   */
+  bool sample(int solution[9][9]);
+
+  long long produced() const { return produced_count; }
+  long long nodes() const { return node_count; }
+
+  /**
+   * Nodes over every load() and sample() of this enumerator
+   */
+  long long total_nodes() const { return earlier_nodes + node_count; }
+
+  void cancel() { cancel_requested.store(true, std::memory_order_relaxed); }
+  bool cancelled() const { return cancel_requested.load(std::memory_order_relaxed); }
+
+private:
+  struct Frame
+  {
+    uint8_t cell;
+    uint8_t digit;       // placed digit, 0 before the first try
+    uint16_t remaining;  // digits still to try
+  };
+
+  bool advance();
+  int take_digit(uint16_t &remaining);
+  void place(int cell, int digit);
+  void unplace(int cell, int digit);
+
+  int givens[9][9];
+  uint8_t cells[81];
+  uint16_t rows[9], cols[9], boxes[9];
+  Frame stack[81];
+  int depth;
+  bool valid;
+  bool started;
+  bool finished;
+  uint64_t random_seed;
+  uint64_t random_state;
+  long long produced_count;
+  long long node_count;
+  long long earlier_nodes; // nodes of the enumerations before the last load()
+  std::atomic<bool> cancel_requested;
+};
@@ -1,29 +1,86 @@
+// Build:
+//   g++ -o sudokuGUI sudokuGUI.cpp sudokuBoard.cpp sudokuEngine.cpp sudokuHints.cpp solveTrace.cpp answerEntry.cpp deviceSession.cpp sudokuOcr.cpp ocrResolve.cpp pipelineTrace.cpp -pthread `fltk-config --cxxflags --ldflags` `pkg-config --cflags --libs opencv4`
+
 #include <FL/Fl.H>
 #include <FL/Fl_Window.H>
-#include <FL/Fl_Choice.H>
 #include <FL/Fl_Button.H>
 #include <FL/fl_ask.H>
 #include <FL/Fl_Box.H>
+#include <FL/Fl_Check_Button.H>
+#include <FL/Fl_Value_Slider.H>
+#include <FL/Fl_File_Chooser.H>
 #include <string>
 #include <vector>
 #include <cctype>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <atomic>
+#include <thread>
+#include <opencv2/opencv.hpp>
+#include "answerEntry.h"
+#include "deviceSession.h"
+#include "sudokuOcr.h"
+#include "sudokuEngine.h"
+#include "sudokuBoard.h"
+#include "solveTrace.h"
+#include "sudokuHints.h"
+#include "pipelineTrace.h"
 
 class SudokuGUI
 {
 private:
   // GUI components
   Fl_Window *window;
-  Fl_Choice *grid[9][9]; // 9x9 grid of combo boxes
+  SudokuBoard *board; // 9x9 board drawn by a single widget
   Fl_Button *write_button;
   Fl_Button *solve_button;
+  Fl_Button *hint_button;
   Fl_Button *clear_button; // Кнопка очистки
   Fl_Button *scan_button;
+  Fl_Button *enter_button;
+  Fl_Check_Button *auto_solve_button; // Solve right after a successful scan
+  Fl_Box *status_box;                 // Solve progress
+  Fl_Check_Button *visualize_button;  // Show the search live and record it
+  Fl_Value_Slider *speed_slider;      // Replay speed, events per second
+  Fl_Button *replay_button;
+  Fl_Button *save_trace_button;
+  Fl_Button *load_trace_button;
 
   // Data storage
   int sudoku_board[9][9];    // Current state of the board
   bool original_cells[9][9]; // Track which cells were originally filled
+  int solved_board[9][9];    // last solution shown; Enter only types this board
+  bool has_solution;         // reset by Scan and Clear
+
+  // Background solving: the worker owns solver.board until it posts solve_finished
+  BacktrackingSolver solver;
+  std::thread solve_thread;
+  bool solving;                          // only touched on the FLTK thread
+  bool solve_result;                     // written by the worker before it posts
+  std::atomic<long long> progress_nodes;
+  std::atomic<double> progress_seconds;
+
+  // Search visualization: live view drains trace every frame, replay walks replay_events
+  SolveTrace trace;
+  std::vector<SolveEvent> frame_events;  // scratch buffer for one frame
+  std::vector<SolveEvent> replay_events; // last recorded or loaded trace
+  int replay_puzzle[9][9];               // board the trace starts from
+  std::string replay_engine;
+  size_t replay_position;
+  bool replaying;
+  bool tracing; // the running solve records into trace
+  bool live_behind; // the ring dropped events: the live view stopped applying them
+
+  // Hints: candidates follow the board between presses, shown cells are restored on the next one
+  HintEngine hints;
+  std::vector<std::pair<int, SudokuBoard::CellStyle>> hint_styles;
+
+  // Answer entry: empty path sends input to the device, otherwise records it to this file
+  std::string dry_run_path;
+  DeviceSession device; // opened on first use, kept for the whole run
+  std::vector<cv::Mat> templates; // digit templates, loaded on first scan
 
   // Constants for layout
   static const int CELL_SIZE = 40;
@@ -31,10 +88,14 @@ private:
   static const int GRID_START_X = 20;
   static const int GRID_START_Y = 50; // Move grid down for title
   static const int WINDOW_WIDTH = 450;
-  static const int WINDOW_HEIGHT = 550;
+  static const int WINDOW_HEIGHT = 670;
+  static constexpr double FRAME_SECONDS = 1.0 / 30; // visualization frame period
+  static constexpr double LOW_CONFIDENCE = 0.95; // scanned cells below this are highlighted
 
 public:
   SudokuGUI()
+      : has_solution(false), solving(false), solve_result(false), progress_nodes(0), progress_seconds(0),
+        replay_position(0), replaying(false), tracing(false), live_behind(false)
   {
     // Initialize the board and tracking arrays
     for (int i = 0; i < 9; i++)
@@ -43,6 +104,8 @@ public:
       {
         sudoku_board[i][j] = 0;
         original_cells[i][j] = false;
+        solved_board[i][j] = 0;
+        replay_puzzle[i][j] = 0;
       }
     }
 
@@ -53,6 +116,11 @@ public:
 
   ~SudokuGUI()
   {
+    if (solve_thread.joinable())
+    {
+      solver.cancel();
+      solve_thread.join();
+    }
     delete window;
   }
 
@@ -61,6 +129,11 @@ public:
     window->show();
   }
 
+  void set_dry_run(const std::string &path)
+  {
+    dry_run_path = path;
+  }
+
 private:
   /**
    * Creates the main window for the application
@@ -77,38 +150,12 @@ private:
   }
 
   /**
-   * Creates the 9x9 grid of combo boxes
-   * Each cell is positioned to form a proper Sudoku grid layout
+   * Creates the board widget that draws all 81 cells
    */
   void create_grid()
   {
-    Fl_Color block_colors[2] = {FL_WHITE, fl_rgb_color(230, 230, 230)}; // white and light gray
-    for (int row = 0; row < 9; row++)
-    {
-      for (int col = 0; col < 9; col++)
-      {
-        // Increase extra spacing for 3x3 block separation
-        int x = GRID_START_X + col * (CELL_SIZE + CELL_MARGIN) + (col / 3) * 12;
-        int y = GRID_START_Y + row * (CELL_SIZE + CELL_MARGIN) + (row / 3) * 12;
-
-        grid[row][col] = new Fl_Choice(x, y, CELL_SIZE, CELL_SIZE);
-        grid[row][col]->textsize(18);
-
-        // Add choices "0" (empty), "1", ..., "9"
-        grid[row][col]->add("0");
-        for (int n = 1; n <= 9; n++)
-        {
-          char buf[2];
-          sprintf(buf, "%d", n);
-          grid[row][col]->add(buf);
-        }
-        grid[row][col]->value(0); // Default to "0" (empty)
-        // Alternate block background color
-        int block_color_idx = ((row / 3) + (col / 3)) % 2;
-        grid[row][col]->color(block_colors[block_color_idx]);
-        grid[row][col]->textcolor(FL_BLACK);
-      }
-    }
+    int size = 9 * (CELL_SIZE + CELL_MARGIN) + 2 * 12;
+    board = new SudokuBoard(GRID_START_X, GRID_START_Y, size, size);
   }
 
   /**
@@ -118,18 +165,49 @@ private:
   {
     int button_y = GRID_START_Y + 9 * (CELL_SIZE + CELL_MARGIN) + 4 * 5 + 20;
     int button_x = (WINDOW_WIDTH - 120) / 2; // Center button
-    solve_button = new Fl_Button(button_x, button_y, 120, 30, "Solve");
+
+    // Первый ряд из четырёх кнопок поуже: Write, Solve, Hint, Clear
+    write_button = new Fl_Button(GRID_START_X, button_y, 95, 30, "Write");
+    write_button->callback(write_callback, this);
+
+    solve_button = new Fl_Button(GRID_START_X + 105, button_y, 95, 30, "Solve");
     solve_button->callback(solve_callback, this);
 
-    // Кнопка очистки справа от Solve
-    clear_button = new Fl_Button(button_x + 140, button_y, 120, 30, "Clear");
-    clear_button->callback(clear_callback, this);
+    hint_button = new Fl_Button(GRID_START_X + 210, button_y, 95, 30, "Hint");
+    hint_button->callback(hint_callback, this);
 
-    write_button = new Fl_Button(button_x - 140, button_y, 120, 30, "Write");
-    write_button->callback(write_callback, this);
+    // Кнопка очистки справа от Hint
+    clear_button = new Fl_Button(GRID_START_X + 315, button_y, 95, 30, "Clear");
+    clear_button->callback(clear_callback, this);
 
     scan_button = new Fl_Button(button_x, button_y + 40, 120, 30, "Scan");
     scan_button->callback(scan_callback, this);
+
+    enter_button = new Fl_Button(button_x + 140, button_y + 40, 120, 30, "Enter");
+    enter_button->callback(enter_callback, this);
+
+    auto_solve_button = new Fl_Check_Button(button_x - 140, button_y + 40, 120, 30, "Auto-solve");
+
+    visualize_button = new Fl_Check_Button(button_x - 140, button_y + 80, 120, 30, "Visualize");
+
+    speed_slider = new Fl_Value_Slider(button_x, button_y + 80, 260, 30);
+    speed_slider->type(FL_HOR_NICE_SLIDER);
+    speed_slider->bounds(1, 5000);
+    speed_slider->step(1);
+    speed_slider->value(200);
+    speed_slider->tooltip("Replay speed, events per second");
+
+    replay_button = new Fl_Button(button_x - 140, button_y + 120, 120, 30, "Replay");
+    replay_button->callback(replay_callback, this);
+
+    save_trace_button = new Fl_Button(button_x, button_y + 120, 120, 30, "Save trace");
+    save_trace_button->callback(save_trace_callback, this);
+
+    load_trace_button = new Fl_Button(button_x + 140, button_y + 120, 120, 30, "Load trace");
+    load_trace_button->callback(load_trace_callback, this);
+
+    status_box = new Fl_Box(GRID_START_X, button_y + 160, WINDOW_WIDTH - 2 * GRID_START_X, 30);
+    status_box->align(FL_ALIGN_CENTER | FL_ALIGN_INSIDE);
   }
 
   /**
@@ -141,6 +219,12 @@ private:
     gui->solve_sudoku();
   }
 
+  static void hint_callback(Fl_Widget *widget, void *data)
+  {
+    SudokuGUI *gui = (SudokuGUI *)data;
+    gui->show_hint();
+  }
+
   static void clear_callback(Fl_Widget *widget, void *data)
   {
     SudokuGUI *gui = (SudokuGUI *)data;
@@ -153,22 +237,96 @@ private:
   }
 
   static void scan_callback(Fl_Widget *widget, void *data) {
-      int result = std::system("./matchTemplate"); // или ./extract_digits
-      if (result != 0) {
-          std::cerr << "Error: OCR script failed with code " << result << std::endl;
-      }
+    SudokuGUI *gui = (SudokuGUI *)data;
+    gui->scan_board();
+  }
+
+  static void enter_callback(Fl_Widget *widget, void *data)
+  {
+    SudokuGUI *gui = (SudokuGUI *)data;
+    gui->enter_answer();
   }
 
   /**
-   * Main solving function that coordinates the entire process
+   * Fl::awake handlers, run on the FLTK thread for messages from the solve worker
+   */
+  static void solve_progress_awake(void *data)
+  {
+    SudokuGUI *gui = (SudokuGUI *)data;
+    gui->show_solve_progress();
+  }
+
+  static void solve_finished_awake(void *data)
+  {
+    SudokuGUI *gui = (SudokuGUI *)data;
+    gui->finish_solve();
+  }
+
+  static void replay_callback(Fl_Widget *widget, void *data)
+  {
+    SudokuGUI *gui = (SudokuGUI *)data;
+    gui->toggle_replay();
+  }
+
+  static void save_trace_callback(Fl_Widget *widget, void *data)
+  {
+    SudokuGUI *gui = (SudokuGUI *)data;
+    gui->save_solve_trace();
+  }
+
+  static void load_trace_callback(Fl_Widget *widget, void *data)
+  {
+    SudokuGUI *gui = (SudokuGUI *)data;
+    gui->load_solve_trace();
+  }
+
+  /**
+   * Frame timers for the live view and the replay
+   */
+  static void live_frame_timeout(void *data)
+  {
+    SudokuGUI *gui = (SudokuGUI *)data;
+    gui->show_live_frame();
+    if (gui->solving)
+    {
+      Fl::repeat_timeout(FRAME_SECONDS, live_frame_timeout, data);
+    }
+  }
+
+  static void replay_frame_timeout(void *data)
+  {
+    SudokuGUI *gui = (SudokuGUI *)data;
+    if (gui->show_replay_frame())
+    {
+      Fl::repeat_timeout(FRAME_SECONDS, replay_frame_timeout, data);
+    }
+  }
+
+  /**
+   * Main solving function that coordinates the entire process.
+   * The search runs on a worker thread; pressing the button again cancels it.
    */
   void solve_sudoku()
   {
+    if (solving)
+    {
+      solver.cancel();
+      status_box->copy_label("Cancelling...");
+      return;
+    }
+
+    // A replay in progress is not the user's board: go back to its puzzle
+    if (replaying)
+    {
+      stop_replay();
+      show_replay_start();
+    }
+
     // Step 1: Read current values from GUI into internal board
     read_board_from_gui();
 
     // Step 2: Validate the current board state
-    if (!is_valid_board())
+    if (!is_valid_board(sudoku_board))
     {
       fl_alert("Invalid Sudoku configuration! Please check your input.");
       return;
@@ -177,201 +335,388 @@ private:
     // Step 3: Mark which cells are originally filled
     mark_original_cells();
 
-    // Step 4: Solve using backtracking algorithm
-    if (solve_backtracking(0, 0))
+    for (int i = 0; i < 9; i++)
     {
-      // Step 5: Update GUI with solution and apply colors
-      update_gui_with_solution();
-      fl_message("Sudoku solved successfully!");
+      for (int j = 0; j < 9; j++)
+      {
+        replay_puzzle[i][j] = sudoku_board[i][j];
+      }
+    }
+
+    // Step 4: Solve using backtracking algorithm on a worker thread
+    solver.load(sudoku_board);
+    tracing = visualize_button->value();
+    live_behind = false;
+    if (tracing)
+    {
+      trace.reset(true);
+      solver.set_trace(&trace);
+      Fl::add_timeout(FRAME_SECONDS, live_frame_timeout, this);
     }
     else
     {
-      fl_alert("No solution exists for this Sudoku puzzle!");
+      solver.set_trace(nullptr);
     }
+    solver.set_progress_callback([this](long long nodes, double seconds)
+                                 {
+                                   progress_nodes.store(nodes);
+                                   progress_seconds.store(seconds);
+                                   Fl::awake(solve_progress_awake, this);
+                                 },
+                                 std::chrono::milliseconds(100));
+    set_solving(true);
+    solve_thread = std::thread([this]()
+                               {
+                                 {
+                                   TRACE_SCOPE(STAGE_SOLVE);
+                                   solve_result = solver.solve();
+                                 }
+                                 Fl::awake(solve_finished_awake, this);
+                               });
   }
 
   /**
-   * Reads all values from the GUI combo boxes into the internal board
+   * Swaps Solve for Cancel and locks the actions that touch the board
+   * while a solve is in flight
    */
-  void read_board_from_gui()
+  void set_solving(bool value)
   {
-    for (int i = 0; i < 9; i++)
+    solving = value;
+    solve_button->label(solving ? "Cancel" : "Solve");
+    Fl_Widget *board_actions[] = {clear_button, write_button, hint_button, scan_button, enter_button,
+                                  replay_button, save_trace_button, load_trace_button};
+    for (Fl_Widget *button : board_actions)
     {
-      for (int j = 0; j < 9; j++)
-      {
-        int idx = grid[i][j]->value();
-        // idx 0 is "0" (empty), idx 1 is "1", ..., idx 9 is "9"
-        sudoku_board[i][j] = idx; // 0 means empty
-      }
+      if (solving)
+        button->deactivate();
+      else
+        button->activate();
     }
+    status_box->copy_label(solving ? "Solving..." : "");
   }
 
-  /**
-   * Validates that the current board configuration is legal
-   * Checks for duplicate numbers in rows, columns, and 3x3 boxes
-   */
-  bool is_valid_board()
+  void show_solve_progress()
   {
-    // Check rows
-    for (int row = 0; row < 9; row++)
+    if (!solving)
     {
-      bool used[10] = {false}; // Track digits 1-9
-      for (int col = 0; col < 9; col++)
+      return;
+    }
+    char buf[128];
+    snprintf(buf, sizeof(buf), "Solving... %lld nodes, %.1f s%s", progress_nodes.load(), progress_seconds.load(),
+             live_behind ? " (view fell behind)" : "");
+    status_box->copy_label(buf);
+  }
+
+  void finish_solve()
+  {
+    solve_thread.join();
+    bool cancelled = solver.cancelled();
+    set_solving(false);
+
+    Fl::remove_timeout(live_frame_timeout, this);
+    bool traced = tracing;
+    if (tracing)
+    {
+      tracing = false;
+      // Events still in the ring belong to this solve; the next one resets the ring
+      show_live_frame();
+      if (trace.recording_truncated())
       {
-        int num = sudoku_board[row][col];
-        if (num != 0)
-        {
-          if (used[num])
-            return false; // Duplicate found
-          used[num] = true;
-        }
+        std::cerr << "Solve trace truncated, only the first " << trace.recorded_events()
+                  << " events were recorded" << std::endl;
       }
+      trace.take_recording(replay_events);
+      replay_engine = solver.name();
+      solver.set_trace(nullptr);
     }
 
-    // Check columns
-    for (int col = 0; col < 9; col++)
+    char buf[96];
+    snprintf(buf, sizeof(buf), "%lld nodes, %.2f s", progress_nodes.load(), progress_seconds.load());
+    status_box->copy_label(buf);
+
+    if (solve_result)
     {
-      bool used[10] = {false};
-      for (int row = 0; row < 9; row++)
+      // Step 5: Update GUI with solution and apply colors
+      for (int i = 0; i < 9; i++)
       {
-        int num = sudoku_board[row][col];
-        if (num != 0)
+        for (int j = 0; j < 9; j++)
         {
-          if (used[num])
-            return false;
-          used[num] = true;
+          sudoku_board[i][j] = solver.board[i][j];
+          solved_board[i][j] = solver.board[i][j];
         }
       }
+      has_solution = true;
+      update_gui_with_solution();
+      fl_message("Sudoku solved successfully!");
     }
+    else
+    {
+      // The live view left half a search on the board (and may have dropped
+      // events): put the puzzle back so the next Solve does not read it as clues
+      if (traced)
+      {
+        show_replay_start();
+      }
+      if (cancelled)
+      {
+        status_box->copy_label("Solve cancelled");
+      }
+      else
+      {
+        fl_alert("No solution exists for this Sudoku puzzle!");
+      }
+    }
+  }
 
-    // Check 3x3 boxes
-    for (int box_row = 0; box_row < 3; box_row++)
+  /**
+   * Applies trace events to the board widget. Several events on the same
+   * cell within one frame coalesce: the widget repaints each cell once.
+   */
+  void apply_events(const SolveEvent *events, size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
     {
-      for (int box_col = 0; box_col < 3; box_col++)
+      int row = events[i].cell / 9;
+      int col = events[i].cell % 9;
+      if (events[i].type == EVENT_REMOVE)
       {
-        bool used[10] = {false};
-        for (int row = box_row * 3; row < box_row * 3 + 3; row++)
-        {
-          for (int col = box_col * 3; col < box_col * 3 + 3; col++)
-          {
-            int num = sudoku_board[row][col];
-            if (num != 0)
-            {
-              if (used[num])
-                return false;
-              used[num] = true;
-            }
-          }
-        }
+        board->value(row, col, 0);
+      }
+      else
+      {
+        board->value(row, col, events[i].digit);
+        board->style(row, col, events[i].type == EVENT_PROPAGATE ? SudokuBoard::STYLE_HIGHLIGHT : SudokuBoard::STYLE_SOLVED);
       }
     }
+  }
 
-    return true;
+  /**
+   * Live view: shows whatever the solver did since the last frame.
+   * The solver never waits for the GUI. Once the ring has dropped events
+   * the board can no longer follow the search, so the view goes back to
+   * the puzzle, stops applying events and says so in the status; the
+   * recording stays complete and finish_solve shows the result.
+   */
+  void show_live_frame()
+  {
+    if (live_behind)
+    {
+      return;
+    }
+    frame_events.clear();
+    trace.drain(frame_events);
+    if (trace.dropped_events() > 0)
+    {
+      live_behind = true;
+      show_replay_start();
+      show_solve_progress();
+      return;
+    }
+    apply_events(frame_events.data(), frame_events.size());
   }
 
   /**
-   * Records which cells were originally filled by the user
+   * Shows the trace's starting board with clues styled as given
    */
-  void mark_original_cells()
+  void show_replay_start()
   {
+    board->clear();
     for (int i = 0; i < 9; i++)
     {
       for (int j = 0; j < 9; j++)
       {
-        original_cells[i][j] = (sudoku_board[i][j] != 0);
+        board->value(i, j, replay_puzzle[i][j]);
+        if (replay_puzzle[i][j] != 0)
+        {
+          board->style(i, j, SudokuBoard::STYLE_GIVEN);
+        }
       }
     }
   }
 
+  void toggle_replay()
+  {
+    if (replaying)
+    {
+      stop_replay();
+      return;
+    }
+    if (solving || replay_events.empty())
+    {
+      fl_alert("Nothing to replay. Solve with Visualize on or load a trace first.");
+      return;
+    }
+
+    show_replay_start();
+    replay_position = 0;
+    replaying = true;
+    replay_button->label("Stop");
+    Fl::add_timeout(FRAME_SECONDS, replay_frame_timeout, this);
+  }
+
+  void stop_replay()
+  {
+    if (replaying)
+    {
+      Fl::remove_timeout(replay_frame_timeout, this);
+      replaying = false;
+      replay_button->label("Replay");
+    }
+  }
+
   /**
-   * Backtracking algorithm to solve the Sudoku puzzle
-   * @param row Current row being processed
-   * @param col Current column being processed
-   * @return true if solution found, false otherwise
+   * Advances the replay by one frame at the chosen speed
+   * @return true while there are events left
    */
-  bool solve_backtracking(int row, int col)
+  bool show_replay_frame()
   {
-    // Base case: if we've processed all rows, solution is complete
-    if (row == 9)
+    size_t per_frame = (size_t)(speed_slider->value() * FRAME_SECONDS) + 1;
+    size_t count = std::min(per_frame, replay_events.size() - replay_position);
+    apply_events(replay_events.data() + replay_position, count);
+    replay_position += count;
+
+    char buf[96];
+    snprintf(buf, sizeof(buf), "Replay %s: %zu / %zu events", replay_engine.c_str(), replay_position,
+             replay_events.size());
+    status_box->copy_label(buf);
+
+    if (replay_position >= replay_events.size())
     {
-      return true;
+      replaying = false;
+      replay_button->label("Replay");
+      return false;
     }
+    return true;
+  }
 
-    // Move to next row when we reach the end of current row
-    if (col == 9)
+  void save_solve_trace()
+  {
+    if (replay_events.empty())
     {
-      return solve_backtracking(row + 1, 0);
+      fl_alert("No trace recorded. Solve with Visualize on first.");
+      return;
     }
-
-    // If cell is already filled, move to next cell
-    if (sudoku_board[row][col] != 0)
+    const char *path = fl_file_chooser("Save solve trace", "*.txt", "solve_trace.txt");
+    if (path && !save_trace(path, replay_engine, replay_puzzle, replay_events))
     {
-      return solve_backtracking(row, col + 1);
+      fl_alert("Failed writing the trace file!");
     }
+  }
 
-    // Try digits 1-9 for empty cell
-    for (int num = 1; num <= 9; num++)
+  void load_solve_trace()
+  {
+    const char *path = fl_file_chooser("Load solve trace", "*.txt", nullptr);
+    if (!path)
     {
-      if (is_safe(row, col, num))
-      {
-        sudoku_board[row][col] = num; // Place number
+      return;
+    }
+    stop_replay();
+    if (!load_trace(path, replay_engine, replay_puzzle, replay_events))
+    {
+      fl_alert("Not a valid solve trace file!");
+      return;
+    }
+    toggle_replay();
+  }
 
-        // Recursively solve remaining cells
-        if (solve_backtracking(row, col + 1))
-        {
-          return true; // Solution found
-        }
+  /**
+   * Shows the next logical step for the board as it is now: the cells it is
+   * based on are highlighted, the placement or eliminations are applied and
+   * the remaining candidates are drawn as pencil marks
+   */
+  void show_hint()
+  {
+    if (solving)
+    {
+      return;
+    }
+    if (replaying)
+    {
+      stop_replay();
+      show_replay_start();
+    }
+    clear_hint();
+    read_board_from_gui();
+    hints.sync(sudoku_board);
 
-        // Backtrack: remove number and try next
-        sudoku_board[row][col] = 0;
+    Hint hint;
+    if (!hints.next_hint(hint))
+    {
+      bool complete = true;
+      for (int cell = 0; cell < 81; cell++)
+      {
+        complete = complete && sudoku_board[cell / 9][cell % 9] != 0;
       }
+      status_box->copy_label(complete ? "The board is complete" : "No simple step left, use Solve");
+      return;
+    }
+
+    for (int cell : hint.cells)
+    {
+      hint_styles.push_back(std::make_pair(cell, board->style(cell / 9, cell % 9)));
+      board->style(cell / 9, cell % 9, SudokuBoard::STYLE_HIGHLIGHT);
+    }
+    if (hint.technique != Hint::CONTRADICTION)
+    {
+      hints.apply(hint);
+    }
+    if (hint.place_cell >= 0)
+    {
+      board->value(hint.place_cell / 9, hint.place_cell % 9, hint.place_digit);
+      board->style(hint.place_cell / 9, hint.place_cell % 9, SudokuBoard::STYLE_SOLVED);
     }
 
-    return false; // No solution found
+    const CandidateState &state = hints.state();
+    for (int cell = 0; cell < 81; cell++)
+    {
+      board->candidates(cell / 9, cell % 9, state.values[cell] == 0 ? state.candidates[cell] : 0);
+    }
+    status_box->copy_label(hint.description.c_str());
   }
 
   /**
-   * Checks if it's safe to place a number at given position
-   * @param row Row index
-   * @param col Column index
-   * @param num Number to place (1-9)
-   * @return true if placement is valid, false otherwise
+   * Puts back the styles the previous hint highlighted, unless the cell was edited since
    */
-  bool is_safe(int row, int col, int num)
+  void clear_hint()
   {
-    // Check row for conflicts
-    for (int j = 0; j < 9; j++)
+    for (const std::pair<int, SudokuBoard::CellStyle> &saved : hint_styles)
     {
-      if (sudoku_board[row][j] == num)
+      int row = saved.first / 9;
+      int col = saved.first % 9;
+      if (board->style(row, col) == SudokuBoard::STYLE_HIGHLIGHT)
       {
-        return false;
+        board->style(row, col, saved.second);
       }
     }
+    hint_styles.clear();
+  }
 
-    // Check column for conflicts
+  /**
+   * Reads all values from the board widget into the internal board
+   */
+  void read_board_from_gui()
+  {
     for (int i = 0; i < 9; i++)
     {
-      if (sudoku_board[i][col] == num)
+      for (int j = 0; j < 9; j++)
       {
-        return false;
+        sudoku_board[i][j] = board->value(i, j); // 0 means empty
       }
     }
+  }
 
-    // Check 3x3 box for conflicts
-    int box_start_row = (row / 3) * 3;
-    int box_start_col = (col / 3) * 3;
-    for (int i = box_start_row; i < box_start_row + 3; i++)
+  /**
+   * Records which cells were originally filled by the user
+   */
+  void mark_original_cells()
+  {
+    for (int i = 0; i < 9; i++)
     {
-      for (int j = box_start_col; j < box_start_col + 3; j++)
+      for (int j = 0; j < 9; j++)
       {
-        if (sudoku_board[i][j] == num)
-        {
-          return false;
-        }
+        original_cells[i][j] = (sudoku_board[i][j] != 0);
       }
     }
-
-    return true;
   }
 
   /**
@@ -384,46 +729,166 @@ private:
     {
       for (int j = 0; j < 9; j++)
       {
-        // Set combo box value
-        grid[i][j]->value(sudoku_board[i][j]); // 0 for "0", 1 for "1", etc.
+        board->value(i, j, sudoku_board[i][j]);
 
-        // Apply color coding
-        if (original_cells[i][j])
-        {
-          // Original user input - keep default appearance
-          grid[i][j]->color(FL_WHITE);
-          grid[i][j]->textcolor(FL_BLACK);
-        }
-        else
+        // Apply color coding: originals stay plain, solver-filled cells turn green
+        board->style(i, j, original_cells[i][j] ? SudokuBoard::STYLE_GIVEN : SudokuBoard::STYLE_SOLVED);
+      }
+    }
+  }
+
+  /**
+   * Captures the device screen and recognizes the board in-process,
+   * filling the grid directly without a subprocess or sudoku.txt.
+   * Cells recognized with low confidence are highlighted for checking.
+   */
+  void scan_board()
+  {
+    if (solving)
+    {
+      return;
+    }
+    if (templates.empty() && !loadTemplates(templates))
+    {
+      fl_alert("Failed loading digit templates!");
+      return;
+    }
+
+    std::vector<unsigned char> png;
+    bool captured;
+    {
+      TRACE_SCOPE(STAGE_CAPTURE);
+      captured = device.capture(png);
+    }
+    if (!captured)
+    {
+      fl_alert("Failed capturing the device screen!");
+      return;
+    }
+
+    cv::Mat screenshot;
+    {
+      TRACE_SCOPE(STAGE_DECODE);
+      screenshot = cv::imdecode(png, cv::IMREAD_COLOR);
+    }
+    ScannedBoard scanned;
+    if (screenshot.empty() || !recognizeBoard(screenshot, "default", templates, scanned))
+    {
+      fl_alert("Failed recognizing the board!");
+      return;
+    }
+
+    // Misread clues are corrected from the runner-up digits when that gives a unique solution
+    Resolution resolution;
+    resolve_scanned_board(scanned.digits, scanned.confidence, scanned.ranked, resolution);
+
+    clear_board();
+    for (int i = 0; i < 9; i++)
+    {
+      for (int j = 0; j < 9; j++)
+      {
+        board->value(i, j, resolution.board[i][j]);
+        if (scanned.confidence[i][j] < LOW_CONFIDENCE)
         {
-          // Solver-filled cell - make it green
-          grid[i][j]->color(FL_GREEN);
-          grid[i][j]->textcolor(FL_BLACK);
+          board->style(i, j, SudokuBoard::STYLE_UNCERTAIN);
         }
       }
     }
 
-    // Refresh the display
-    window->redraw();
+    std::string report;
+    for (const CellCorrection &correction : resolution.corrections)
+    {
+      board->style(correction.row, correction.col, SudokuBoard::STYLE_HIGHLIGHT);
+      char text[32];
+      snprintf(text, sizeof(text), "%sr%dc%d %d->%d", report.empty() ? "Corrected " : ", ", correction.row + 1,
+               correction.col + 1, correction.read_digit, correction.corrected_digit);
+      report += text;
+    }
+    if (!resolution.solved)
+    {
+      report = "Scanned board has no solution, check the yellow cells";
+    }
+    status_box->copy_label(report.c_str());
+
+    // Scanned digits are the clues: Enter must never type them back into the game
+    read_board_from_gui();
+    mark_original_cells();
+
+    if (auto_solve_button->value())
+    {
+      solve_sudoku();
+    }
+  }
+
+  /**
+   * Types the solver-filled cells into the game on the device
+   * (or into the dry-run file) through a single input session
+   */
+  void enter_answer()
+  {
+    if (solving)
+    {
+      return;
+    }
+    read_board_from_gui();
+
+    // original_cells only describe the board the last solve started from
+    if (!has_solution || !std::equal(&sudoku_board[0][0], &sudoku_board[0][0] + 81, &solved_board[0][0]))
+    {
+      fl_alert("The board changed since the last solve. Solve it before entering.");
+      return;
+    }
+
+    std::vector<Tap> taps = plan_taps(sudoku_board, original_cells);
+    if (taps.empty())
+    {
+      fl_alert("Nothing to enter, every cell was a clue.");
+      return;
+    }
+
+    bool entered;
+    if (!dry_run_path.empty())
+    {
+      std::ofstream out(dry_run_path, std::ios::app);
+      RecordingSink sink(out);
+      entered = enter_solution(taps, sink);
+    }
+    else
+    {
+      load_device_geometry(device, "default");
+      entered = enter_solution(taps, device);
+    }
+
+    if (!entered)
+    {
+      fl_alert("Failed to enter the solution on the device!");
+    }
   }
 
   void clear_board()
   {
+    if (solving)
+    {
+      return;
+    }
+    stop_replay();
+    hint_styles.clear();
+    has_solution = false;
+    board->clear();
     for (int i = 0; i < 9; i++)
     {
       for (int j = 0; j < 9; j++)
       {
-        grid[i][j]->value(0); // "0" (пусто)
-        grid[i][j]->color(FL_WHITE);
-        grid[i][j]->textcolor(FL_BLACK);
         sudoku_board[i][j] = 0;
         original_cells[i][j] = false;
       }
     }
-    window->redraw();
   }
 
   void write_grid() {
+    if (solving) {
+      return;
+    }
     int row = 0;
     int column = 0;
     int sudoku[9][9];
@@ -439,7 +904,7 @@ private:
         for (int column = 0; column < 9; ++column) {
           char c = line[column];
           sudoku[row][column] = c - '0';
-          grid[row][column]->value(sudoku[row][column]);
+          board->value(row, column, sudoku[row][column]);
         }
     }
 
@@ -449,9 +914,42 @@ private:
   }
 };
 
-int main() {
+// Saves the trace when SIGUSR1 asked for it
+static void trace_dump_timeout(void *data)
+{
+  if (traceDumpRequested())
+  {
+    traceDump(*(std::string *)data);
+  }
+  Fl::repeat_timeout(1.0, trace_dump_timeout, data);
+}
+
+int main(int argc, char **argv) {
   SudokuGUI sudoku_gui;
+  std::string trace_path;
+
+  // --dry-run <file>: record answer entry events instead of sending them to the device
+  // --trace <file.json>: time scan and solve stages, saved on exit and on SIGUSR1
+  for (int i = 1; i + 1 < argc; i++) {
+    if (std::string(argv[i]) == "--dry-run") {
+      sudoku_gui.set_dry_run(argv[i + 1]);
+    } else if (std::string(argv[i]) == "--trace") {
+      trace_path = argv[i + 1];
+      trace_enabled = true;
+    }
+  }
+  if (trace_enabled) {
+    traceInstallDumpSignal();
+    Fl::add_timeout(1.0, trace_dump_timeout, &trace_path);
+  }
+
+  // Enables Fl::awake() messages from the solve thread
+  Fl::lock();
   sudoku_gui.show();
 
-  return Fl::run();
+  int result = Fl::run();
+  if (trace_enabled) {
+    traceDump(trace_path);
+  }
+  return result;
 }
\ No newline at end of file
@@ -0,0 +1,516 @@
+#include "sudokuHints.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+
+static const unsigned short ALL_DIGITS = 0x3FE; // bits 1..9
+
+// 27 groups: rows 0-8, columns 9-17, boxes 18-26
+static int units[27][9];
+// The 20 cells sharing a row, column or box with each cell
+static int peers[81][20];
+// HintEngine runs on several libsudoku handles at once, the first use must not race
+static std::once_flag tables_once;
+
+static void fill_tables()
+{
+  for (int i = 0; i < 9; i++)
+  {
+    for (int j = 0; j < 9; j++)
+    {
+      units[i][j] = i * 9 + j;
+      units[9 + i][j] = j * 9 + i;
+      units[18 + i][j] = (i / 3 * 3 + j / 3) * 9 + i % 3 * 3 + j % 3;
+    }
+  }
+  for (int cell = 0; cell < 81; cell++)
+  {
+    int row = cell / 9;
+    int col = cell % 9;
+    int count = 0;
+    for (int other = 0; other < 81; other++)
+    {
+      int other_row = other / 9;
+      int other_col = other % 9;
+      bool same_box = row / 3 == other_row / 3 && col / 3 == other_col / 3;
+      if (other != cell && (row == other_row || col == other_col || same_box))
+      {
+        peers[cell][count++] = other;
+      }
+    }
+  }
+}
+
+static void build_tables()
+{
+  std::call_once(tables_once, fill_tables);
+}
+
+static int bit_count(unsigned short mask)
+{
+  return __builtin_popcount(mask);
+}
+
+static int lowest_digit(unsigned short mask)
+{
+  return __builtin_ctz(mask);
+}
+
+static int box_of(int cell)
+{
+  return cell / 27 * 3 + cell % 9 / 3;
+}
+
+/**
+ * "r3c5" with 1-based row and column, as players name cells
+ */
+static std::string cell_name(int cell)
+{
+  char name[16];
+  snprintf(name, sizeof(name), "r%dc%d", cell / 9 + 1, cell % 9 + 1);
+  return name;
+}
+
+static std::string unit_name(int unit)
+{
+  char name[16];
+  if (unit < 9)
+    snprintf(name, sizeof(name), "row %d", unit + 1);
+  else if (unit < 18)
+    snprintf(name, sizeof(name), "column %d", unit - 9 + 1);
+  else
+    snprintf(name, sizeof(name), "box %d", unit - 18 + 1);
+  return name;
+}
+
+void CandidateState::load(const int board[9][9])
+{
+  build_tables();
+  for (int cell = 0; cell < 81; cell++)
+  {
+    values[cell] = board[cell / 9][cell % 9];
+    candidates[cell] = values[cell] == 0 ? ALL_DIGITS : 0;
+  }
+  for (int cell = 0; cell < 81; cell++)
+  {
+    if (values[cell] != 0)
+    {
+      for (int peer : peers[cell])
+      {
+        candidates[peer] &= ~(1 << values[cell]);
+      }
+    }
+  }
+}
+
+void CandidateState::place(int cell, int digit)
+{
+  values[cell] = digit;
+  candidates[cell] = 0;
+  for (int peer : peers[cell])
+  {
+    candidates[peer] &= ~(1 << digit);
+  }
+}
+
+const char *technique_name(Hint::Technique technique)
+{
+  switch (technique)
+  {
+  case Hint::CONTRADICTION:
+    return "Contradiction";
+  case Hint::NAKED_SINGLE:
+    return "Naked single";
+  case Hint::HIDDEN_SINGLE:
+    return "Hidden single";
+  case Hint::POINTING:
+    return "Pointing";
+  case Hint::CLAIMING:
+    return "Claiming";
+  case Hint::NAKED_PAIR:
+    return "Naked pair";
+  case Hint::HIDDEN_PAIR:
+    return "Hidden pair";
+  default:
+    return "None";
+  }
+}
+
+HintEngine::HintEngine() : loaded(false)
+{
+  build_tables();
+}
+
+void HintEngine::sync(const int board[9][9])
+{
+  bool rebuild = !loaded;
+  for (int cell = 0; cell < 81 && !rebuild; cell++)
+  {
+    int digit = board[cell / 9][cell % 9];
+    if (digit == current.values[cell])
+    {
+      continue;
+    }
+    // Only a digit placed into an empty cell where it is still possible can
+    // be applied on top of the current state
+    if (current.values[cell] != 0 || digit < 1 || digit > 9 || !(current.candidates[cell] & (1 << digit)))
+    {
+      rebuild = true;
+    }
+  }
+
+  if (rebuild)
+  {
+    current.load(board);
+    loaded = true;
+    return;
+  }
+  for (int cell = 0; cell < 81; cell++)
+  {
+    int digit = board[cell / 9][cell % 9];
+    if (digit != current.values[cell])
+    {
+      current.place(cell, digit);
+    }
+  }
+}
+
+void HintEngine::apply(const Hint &hint)
+{
+  if (hint.place_cell >= 0)
+  {
+    current.place(hint.place_cell, hint.place_digit);
+  }
+  for (const std::pair<int, int> &elimination : hint.eliminations)
+  {
+    current.eliminate(elimination.first, elimination.second);
+  }
+}
+
+bool HintEngine::next_hint(Hint &hint) const
+{
+  hint.technique = Hint::NONE;
+  hint.cells.clear();
+  hint.place_cell = -1;
+  hint.place_digit = 0;
+  hint.eliminations.clear();
+  hint.description.clear();
+
+  // Simplest techniques first, so the hint is the move a player would look for
+  return find_contradiction(hint) || find_naked_single(hint) || find_hidden_single(hint) ||
+         find_locked_candidates(hint) || find_naked_pair(hint) || find_hidden_pair(hint);
+}
+
+bool HintEngine::find_contradiction(Hint &hint) const
+{
+  char text[128];
+  for (int unit = 0; unit < 27; unit++)
+  {
+    int placed_at[10];
+    unsigned short possible = 0;
+    std::fill(placed_at, placed_at + 10, -1);
+    for (int cell : units[unit])
+    {
+      int digit = current.values[cell];
+      if (digit != 0 && placed_at[digit] >= 0)
+      {
+        hint.technique = Hint::CONTRADICTION;
+        hint.cells = {placed_at[digit], cell};
+        snprintf(text, sizeof(text), "%s: %d appears twice in %s", technique_name(hint.technique), digit,
+                 unit_name(unit).c_str());
+        hint.description = text;
+        return true;
+      }
+      if (digit != 0)
+      {
+        placed_at[digit] = cell;
+        possible |= 1 << digit;
+      }
+      possible |= current.candidates[cell];
+    }
+
+    if (possible != ALL_DIGITS)
+    {
+      hint.technique = Hint::CONTRADICTION;
+      hint.cells.assign(units[unit], units[unit] + 9);
+      snprintf(text, sizeof(text), "%s: %d has no place left in %s", technique_name(hint.technique),
+               lowest_digit(ALL_DIGITS & ~possible), unit_name(unit).c_str());
+      hint.description = text;
+      return true;
+    }
+  }
+
+  for (int cell = 0; cell < 81; cell++)
+  {
+    if (current.values[cell] == 0 && current.candidates[cell] == 0)
+    {
+      hint.technique = Hint::CONTRADICTION;
+      hint.cells = {cell};
+      hint.description = std::string(technique_name(hint.technique)) + ": " + cell_name(cell) + " has no candidates";
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HintEngine::find_naked_single(Hint &hint) const
+{
+  for (int cell = 0; cell < 81; cell++)
+  {
+    if (current.values[cell] == 0 && bit_count(current.candidates[cell]) == 1)
+    {
+      hint.technique = Hint::NAKED_SINGLE;
+      hint.cells = {cell};
+      hint.place_cell = cell;
+      hint.place_digit = lowest_digit(current.candidates[cell]);
+
+      char text[128];
+      snprintf(text, sizeof(text), "%s: %s can only be %d", technique_name(hint.technique), cell_name(cell).c_str(),
+               hint.place_digit);
+      hint.description = text;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HintEngine::find_hidden_single(Hint &hint) const
+{
+  for (int unit = 0; unit < 27; unit++)
+  {
+    for (int digit = 1; digit <= 9; digit++)
+    {
+      int count = 0;
+      int last = -1;
+      for (int cell : units[unit])
+      {
+        if (current.candidates[cell] & (1 << digit))
+        {
+          count++;
+          last = cell;
+        }
+      }
+      if (count != 1)
+      {
+        continue;
+      }
+
+      hint.technique = Hint::HIDDEN_SINGLE;
+      hint.cells.assign(units[unit], units[unit] + 9);
+      hint.place_cell = last;
+      hint.place_digit = digit;
+
+      char text[128];
+      snprintf(text, sizeof(text), "%s: %d fits only %s in %s", technique_name(hint.technique), digit,
+               cell_name(last).c_str(), unit_name(unit).c_str());
+      hint.description = text;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HintEngine::find_locked_candidates(Hint &hint) const
+{
+  // Pointing: inside a box, a digit confined to one row or column is removed
+  // from the rest of that line. Claiming: inside a line, a digit confined to
+  // one box is removed from the rest of that box.
+  for (int unit = 0; unit < 27; unit++)
+  {
+    for (int digit = 1; digit <= 9; digit++)
+    {
+      // hint.cells doubles as the scratch list, so a warm Hint is reused without allocating
+      std::vector<int> &holders = hint.cells;
+      holders.clear();
+      for (int cell : units[unit])
+      {
+        if (current.candidates[cell] & (1 << digit))
+        {
+          holders.push_back(cell);
+        }
+      }
+      if (holders.size() < 2)
+      {
+        continue;
+      }
+
+      int target = -1;
+      if (unit >= 18)
+      {
+        bool same_row = true, same_col = true;
+        for (int cell : holders)
+        {
+          same_row = same_row && cell / 9 == holders[0] / 9;
+          same_col = same_col && cell % 9 == holders[0] % 9;
+        }
+        if (same_row)
+          target = holders[0] / 9;
+        else if (same_col)
+          target = 9 + holders[0] % 9;
+      }
+      else
+      {
+        bool same_box = true;
+        for (int cell : holders)
+        {
+          same_box = same_box && box_of(cell) == box_of(holders[0]);
+        }
+        if (same_box)
+          target = 18 + box_of(holders[0]);
+      }
+      if (target < 0)
+      {
+        continue;
+      }
+
+      for (int cell : units[target])
+      {
+        bool in_source = false;
+        for (int source : units[unit])
+        {
+          in_source = in_source || source == cell;
+        }
+        if (!in_source && (current.candidates[cell] & (1 << digit)))
+        {
+          hint.eliminations.push_back(std::make_pair(cell, digit));
+        }
+      }
+      if (hint.eliminations.empty())
+      {
+        continue;
+      }
+
+      hint.technique = unit >= 18 ? Hint::POINTING : Hint::CLAIMING;
+
+      char text[160];
+      snprintf(text, sizeof(text), "%s: %d in %s is limited to %s, so it goes from the rest of %s",
+               technique_name(hint.technique), digit, unit_name(unit).c_str(), unit_name(target).c_str(),
+               unit_name(target).c_str());
+      hint.description = text;
+      return true;
+    }
+  }
+  hint.cells.clear();
+  return false;
+}
+
+bool HintEngine::find_naked_pair(Hint &hint) const
+{
+  for (int unit = 0; unit < 27; unit++)
+  {
+    for (int a = 0; a < 9; a++)
+    {
+      int first = units[unit][a];
+      unsigned short pair = current.candidates[first];
+      if (bit_count(pair) != 2)
+      {
+        continue;
+      }
+      for (int b = a + 1; b < 9; b++)
+      {
+        int second = units[unit][b];
+        if (current.candidates[second] != pair)
+        {
+          continue;
+        }
+
+        for (int cell : units[unit])
+        {
+          unsigned short common = current.candidates[cell] & pair;
+          if (cell == first || cell == second || common == 0)
+          {
+            continue;
+          }
+          for (int digit = 1; digit <= 9; digit++)
+          {
+            if (common & (1 << digit))
+            {
+              hint.eliminations.push_back(std::make_pair(cell, digit));
+            }
+          }
+        }
+        if (hint.eliminations.empty())
+        {
+          continue;
+        }
+
+        int low = lowest_digit(pair);
+        int high = lowest_digit(pair & ~(1 << low));
+        hint.technique = Hint::NAKED_PAIR;
+        hint.cells = {first, second};
+
+        char text[160];
+        snprintf(text, sizeof(text), "%s: %s and %s hold %d and %d, so they go from the rest of %s",
+                 technique_name(hint.technique), cell_name(first).c_str(), cell_name(second).c_str(), low, high,
+                 unit_name(unit).c_str());
+        hint.description = text;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool HintEngine::find_hidden_pair(Hint &hint) const
+{
+  for (int unit = 0; unit < 27; unit++)
+  {
+    // Which cells of the unit (bit = position 0..8) can hold each digit
+    unsigned short places[10] = {0};
+    for (int k = 0; k < 9; k++)
+    {
+      for (int digit = 1; digit <= 9; digit++)
+      {
+        if (current.candidates[units[unit][k]] & (1 << digit))
+        {
+          places[digit] |= 1 << k;
+        }
+      }
+    }
+
+    for (int low = 1; low <= 9; low++)
+    {
+      if (bit_count(places[low]) != 2)
+      {
+        continue;
+      }
+      for (int high = low + 1; high <= 9; high++)
+      {
+        if (places[high] != places[low])
+        {
+          continue;
+        }
+
+        unsigned short keep = (1 << low) | (1 << high);
+        int first = units[unit][lowest_digit(places[low])];
+        int second = units[unit][lowest_digit(places[low] & (places[low] - 1))];
+        for (int cell : {first, second})
+        {
+          unsigned short extra = current.candidates[cell] & ~keep;
+          for (int digit = 1; digit <= 9; digit++)
+          {
+            if (extra & (1 << digit))
+            {
+              hint.eliminations.push_back(std::make_pair(cell, digit));
+            }
+          }
+        }
+        if (hint.eliminations.empty())
+        {
+          continue;
+        }
+
+        hint.technique = Hint::HIDDEN_PAIR;
+        hint.cells = {first, second};
+
+        char text[160];
+        snprintf(text, sizeof(text), "%s: %d and %d fit only %s and %s in %s, other candidates go from them",
+                 technique_name(hint.technique), low, high, cell_name(first).c_str(), cell_name(second).c_str(),
+                 unit_name(unit).c_str());
+        hint.description = text;
+        return true;
+      }
+    }
+  }
+  return false;
+}
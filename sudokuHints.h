@@ -0,0 +1,91 @@
+#pragma once
+
+// Подсказки: следующий логический ход для текущей доски.
+// Кандидаты хранятся битовыми масками и обновляются инкрементально,
+// так что каждая подсказка — это несколько проходов по 27 группам.
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Values and candidate bitmasks (bit d set = digit d possible) for all 81 cells
+ */
+struct CandidateState
+{
+  int values[81];
+  unsigned short candidates[81];
+
+  /**
+   * Rebuilds candidates from scratch
+   */
+  void load(const int board[9][9]);
+
+  /**
+   * Places a digit and removes it from the candidates of the 20 peers
+   */
+  void place(int cell, int digit);
+
+  void eliminate(int cell, int digit) { candidates[cell] &= ~(1 << digit); }
+};
+
+struct Hint
+{
+  enum Technique
+  {
+    NONE = 0,         // nothing found with the known techniques
+    CONTRADICTION,    // a cell has no candidates left: the board is wrong
+    NAKED_SINGLE,
+    HIDDEN_SINGLE,
+    POINTING,         // box candidates confined to one row/column
+    CLAIMING,         // row/column candidates confined to one box
+    NAKED_PAIR,
+    HIDDEN_PAIR
+  };
+
+  Technique technique;
+  std::vector<int> cells;                       // cells the deduction is based on
+  int place_cell;                               // -1 if the hint only eliminates
+  int place_digit;
+  std::vector<std::pair<int, int>> eliminations; // (cell, digit)
+  std::string description;
+};
+
+const char *technique_name(Hint::Technique technique);
+
+class HintEngine
+{
+public:
+  HintEngine();
+
+  /**
+   * Brings the candidate state up to date with the board. Newly filled
+   * cells are applied incrementally; anything else (a cleared or changed
+   * cell) rebuilds the state and forgets earlier eliminations.
+   */
+  void sync(const int board[9][9]);
+
+  /**
+   * Finds the simplest applicable deduction without applying it
+   * @return false if none of the techniques applies
+   */
+  bool next_hint(Hint &hint) const;
+
+  /**
+   * Applies a hint's placement or eliminations to the candidate state
+   */
+  void apply(const Hint &hint);
+
+  const CandidateState &state() const { return current; }
+
+private:
+  bool find_contradiction(Hint &hint) const;
+  bool find_naked_single(Hint &hint) const;
+  bool find_hidden_single(Hint &hint) const;
+  bool find_locked_candidates(Hint &hint) const;
+  bool find_naked_pair(Hint &hint) const;
+  bool find_hidden_pair(Hint &hint) const;
+
+  CandidateState current;
+  bool loaded;
+};
@@ -0,0 +1,478 @@
+#include "sudokuOcr.h"
+#include "pipelineTrace.h"
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <algorithm>
+#include <map>
+
+int getOffset(int index, int cell_size, int thick, int thin, int margin) {
+    int thick_count = index / 3;
+    int thin_count = index - thick_count;
+    return thick + margin + index * cell_size + thick_count * thick + thin_count * thin;
+}
+
+int cell_size = 113;
+int thick = 5;
+int thin = 3;
+int margin_left = 13;
+// int margin_top = 555; для одиночки
+int margin_top = 567; // для мультиплеера 
+
+// Геометрия, собранная в программу: на неё возвращаемся, если сетку не нашли
+static const GridGeometry DEFAULT_GRID_GEOMETRY = {113, 5, 3, 13, 567};
+
+// Бинаризация сетки
+int grid_adaptive_window = 0;          // 0 — глобальный порог Оцу по всей сетке
+double grid_adaptive_offset = 10.0;    // насколько пиксель темнее среднего окна, чтобы считаться чернилами
+int grid_line_guard = 1;               // сглаженные края линий тоже стираем
+
+// Быстрый отсев пустых ячеек до сопоставления с шаблонами
+int empty_cell_inset = 12;             // отступ от краёв ячейки, чтобы не цеплять линии сетки
+double empty_cell_min_stddev = 10.0;   // ниже — ячейка однотонная, цифры нет
+int empty_cell_min_ink = 80;           // минимум закрашенных пикселей внутри ячейки
+
+double match_threshold = 0.9;          // порог уверенности — цифра только если уверенность высокая
+std::string template_bank_path = "templates.bank";
+std::string template_key = "default";  // набор шаблонов в банке (--templates <key>)
+
+bool isEmptyCell(const cv::Mat& gray, const cv::Mat& binary) {
+  int inset = std::min(empty_cell_inset, std::min(gray.cols, gray.rows) / 4);
+  cv::Rect inner(inset, inset, gray.cols - 2 * inset, gray.rows - 2 * inset);
+
+  cv::Scalar mean, stddev;
+  cv::meanStdDev(gray(inner), mean, stddev);
+  if (stddev[0] < empty_cell_min_stddev) {
+    return true;
+  }
+
+  return cv::countNonZero(binary(inner)) < empty_cell_min_ink;
+}
+
+// Автоматический поиск сетки и кэш калибровки
+std::string calibration_path = "grid_calibration.txt";
+double grid_line_min_fill = 0.6;   // доля тёмных пикселей, чтобы строка/столбец считались линией
+int grid_spacing_tolerance = 3;    // допустимый разброс шага между линиями, px
+
+struct LineRun {
+  int start;
+  int length;
+};
+
+// Ищет 10 линий сетки по проекции бинарного изображения на одну ось.
+// axis = 1 — горизонтальные линии (суммы по строкам), axis = 0 — вертикальные.
+bool findGridLines(const cv::Mat& binary, int axis, std::vector<LineRun>& lines) {
+  cv::Mat projection;
+  cv::reduce(binary, projection, axis, cv::REDUCE_SUM, CV_32S);
+
+  int length = axis == 1 ? binary.rows : binary.cols;
+  int span = axis == 1 ? binary.cols : binary.rows;
+  int minSum = static_cast<int>(grid_line_min_fill * span * 255);
+
+  std::vector<LineRun> runs;
+  for (int i = 0; i < length; ++i) {
+    int value = axis == 1 ? projection.at<int>(i, 0) : projection.at<int>(0, i);
+    if (value < minSum) {
+      continue;
+    }
+    if (!runs.empty() && runs.back().start + runs.back().length == i) {
+      ++runs.back().length;
+    } else {
+      runs.push_back({i, 1});
+    }
+  }
+
+  // Нужна последовательность из 10 линий с одинаковым шагом
+  for (size_t first = 0; first + 10 <= runs.size(); ++first) {
+    int gap = runs[first + 1].start - (runs[first].start + runs[first].length);
+    if (gap <= 0) {
+      continue;
+    }
+    bool regular = true;
+    for (size_t k = first + 1; k < first + 9 && regular; ++k) {
+      int nextGap = runs[k + 1].start - (runs[k].start + runs[k].length);
+      regular = std::abs(nextGap - gap) <= grid_spacing_tolerance;
+    }
+    if (regular) {
+      lines.assign(runs.begin() + first, runs.begin() + first + 10);
+      return true;
+    }
+  }
+  return false;
+}
+
+cv::Mat binarizeScreen(const cv::Mat& image) {
+  cv::Mat gray;
+  cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+  cv::Mat binary;
+  cv::threshold(gray, binary, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+  return binary;
+}
+
+bool locateGrid(const cv::Mat& binary) {
+  std::vector<LineRun> horizontal;
+  if (!findGridLines(binary, 1, horizontal)) {
+    return false;
+  }
+
+  // Вертикальные линии ищем только в полосе, занятой сеткой
+  int top = horizontal.front().start;
+  int bottom = horizontal.back().start + horizontal.back().length;
+  std::vector<LineRun> vertical;
+  if (!findGridLines(binary(cv::Rect(0, top, binary.cols, bottom - top)), 0, vertical)) {
+    return false;
+  }
+
+  thick = vertical[0].length;
+  thin = vertical[1].length;
+  cell_size = vertical[1].start - (vertical[0].start + vertical[0].length);
+  margin_left = vertical[0].start;
+  margin_top = horizontal[0].start;
+  return true;
+}
+
+// Дешёвая проверка закэшированной геометрии: толстые линии должны быть на своих местах
+bool verifyGrid(const cv::Mat& binary) {
+  int gridSize = getOffset(9, cell_size, thick, thin, 0);
+  if (margin_left < 0 || margin_top < 0 ||
+      margin_left + gridSize > binary.cols || margin_top + gridSize > binary.rows) {
+    return false;
+  }
+
+  for (int index = 0; index <= 9; index += 3) {
+    int x = getOffset(index, cell_size, thick, thin, margin_left) - thick + thick / 2;
+    int y = getOffset(index, cell_size, thick, thin, margin_top) - thick + thick / 2;
+
+    int rowInk = cv::countNonZero(binary(cv::Rect(margin_left, y, gridSize, 1)));
+    int columnInk = cv::countNonZero(binary(cv::Rect(x, margin_top, 1, gridSize)));
+    if (rowInk < grid_line_min_fill * gridSize || columnInk < grid_line_min_fill * gridSize) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Проверка по выборке: вместо бинаризации всего экрана берутся только
+// строки и столбцы, где должны быть толстые линии, и для сравнения полосы
+// фона в двух пикселях внутри ячеек. Порог Оцу считается по этой выборке.
+bool verifyGridSample(const cv::Mat& image) {
+  int gridSize = getOffset(9, cell_size, thick, thin, 0);
+  if (cell_size <= 4 || thick <= 0 || margin_left < 0 || margin_top < 0 ||
+      margin_left + gridSize > image.cols || margin_top + gridSize > image.rows) {
+    return false;
+  }
+
+  std::vector<cv::Rect> lines, background;
+  for (int index = 0; index <= 9; index += 3) {
+    int x = getOffset(index, cell_size, thick, thin, margin_left) - thick + thick / 2;
+    int y = getOffset(index, cell_size, thick, thin, margin_top) - thick + thick / 2;
+    lines.push_back(cv::Rect(margin_left, y, gridSize, 1));
+    lines.push_back(cv::Rect(x, margin_top, 1, gridSize));
+    if (index < 9) {
+      background.push_back(cv::Rect(margin_left, getOffset(index, cell_size, thick, thin, margin_top) + 2, gridSize, 1));
+      background.push_back(cv::Rect(getOffset(index, cell_size, thick, thin, margin_left) + 2, margin_top, 1, gridSize));
+    }
+  }
+
+  cv::Mat sample(1, (int)(lines.size() + background.size()) * gridSize, CV_8UC1);
+  int position = 0;
+  for (const std::vector<cv::Rect>* strips : {&lines, &background}) {
+    for (const cv::Rect& strip : *strips) {
+      cv::Mat gray;
+      cv::cvtColor(image(strip), gray, cv::COLOR_BGR2GRAY);
+      for (int i = 0; i < gridSize; ++i) {
+        sample.at<uchar>(0, position++) = strip.height == 1 ? gray.at<uchar>(0, i) : gray.at<uchar>(i, 0);
+      }
+    }
+  }
+  cv::Mat binary;
+  cv::threshold(sample, binary, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+
+  for (size_t strip = 0; strip < lines.size() + background.size(); ++strip) {
+    int ink = cv::countNonZero(binary(cv::Rect((int)strip * gridSize, 0, gridSize, 1)));
+    bool isLine = strip < lines.size();
+    if (isLine ? ink < grid_line_min_fill * gridSize : ink > (1 - grid_line_min_fill) * gridSize) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Кэш калибровки в памяти: файл читается один раз за процесс
+static std::map<std::string, GridGeometry> calibrationCache;
+static bool calibrationCacheLoaded = false;
+
+// Формат строки: <ширина>x<высота> <раскладка> cell_size thick thin margin_left margin_top
+static void loadCalibrationCache() {
+  if (calibrationCacheLoaded) {
+    return;
+  }
+  calibrationCacheLoaded = true;
+  std::ifstream file(calibration_path);
+  std::string entryKey, entryLayout;
+  GridGeometry g;
+  while (file >> entryKey >> entryLayout >> g.cellSize >> g.thick >> g.thin >> g.left >> g.top) {
+    calibrationCache[entryKey + " " + entryLayout] = g;
+  }
+}
+
+static void setGridGeometry(const GridGeometry& g) {
+  cell_size = g.cellSize;
+  thick = g.thick;
+  thin = g.thin;
+  margin_left = g.left;
+  margin_top = g.top;
+}
+
+bool loadCalibration(const std::string& key) {
+  loadCalibrationCache();
+  auto found = calibrationCache.find(key);
+  if (found == calibrationCache.end()) {
+    return false;
+  }
+  setGridGeometry(found->second);
+  return true;
+}
+
+void saveCalibration(const std::string& key) {
+  loadCalibrationCache();
+  calibrationCache[key] = currentGridGeometry();
+
+  std::ofstream file(calibration_path, std::ios::trunc);
+  for (const auto& entry : calibrationCache) {
+    const GridGeometry& g = entry.second;
+    file << entry.first << " " << g.cellSize << " " << g.thick << " " << g.thin << " "
+         << g.left << " " << g.top << "\n";
+  }
+}
+
+std::string calibrationKey(int width, int height, const std::string& layout) {
+  return std::to_string(width) + "x" + std::to_string(height) + " " + layout;
+}
+
+bool loadGridCalibration(int width, int height, const std::string& layout) {
+  return loadCalibration(calibrationKey(width, height, layout));
+}
+
+// Берёт геометрию из кэша, а если её нет или она не подходит — ищет сетку заново
+bool calibrateGrid(const cv::Mat& image, const std::string& layout) {
+  TRACE_SCOPE(STAGE_LOCATE);
+  std::string key = calibrationKey(image.cols, image.rows, layout);
+  if (loadCalibration(key) && verifyGridSample(image)) {
+    return true;
+  }
+
+  // Весь экран бинаризуется только для поиска сетки заново
+  std::cout << "Detecting grid for " << key << "..." << std::endl;
+  cv::Mat binary = binarizeScreen(image);
+  if (!locateGrid(binary) || !verifyGrid(binary)) {
+    setGridGeometry(DEFAULT_GRID_GEOMETRY);
+    return false;
+  }
+
+  saveCalibration(key);
+  std::cout << "Grid found: cell " << cell_size << ", lines " << thick << "/" << thin
+            << ", margins " << margin_left << "," << margin_top << std::endl;
+  return true;
+}
+
+cv::Rect cellRect(int row, int column, const cv::Mat& image) {
+  int x = getOffset(column, cell_size, thick, thin, margin_left);
+  int y = getOffset(row, cell_size, thick, thin, margin_top);
+
+  cv::Rect roi(x, y, cell_size, cell_size);
+  roi.width = std::min(roi.width, image.cols - roi.x);
+  roi.height = std::min(roi.height, image.rows - roi.y);
+  return roi;
+}
+
+void binarizeGray(const cv::Mat& gray, cv::Mat& binary) {
+  if (grid_adaptive_window > 0) {
+    // Среднее по окну считается box-фильтром, как по интегральному изображению
+    cv::adaptiveThreshold(gray, binary, 255, cv::ADAPTIVE_THRESH_MEAN_C, cv::THRESH_BINARY_INV,
+                          std::max(3, grid_adaptive_window | 1), grid_adaptive_offset);
+  } else {
+    cv::threshold(gray, binary, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+  }
+}
+
+void binarizeCell(const cv::Mat& cell, cv::Mat& gray, cv::Mat& binary) {
+  cv::cvtColor(cell, gray, cv::COLOR_BGR2GRAY);
+  binarizeGray(gray, binary);
+}
+
+GridGeometry currentGridGeometry() {
+  return {cell_size, thick, thin, margin_left, margin_top};
+}
+
+bool binarizeGrid(const cv::Mat& screenshot, const GridGeometry& geometry, BinarizedGrid& grid) {
+  TRACE_SCOPE(STAGE_THRESHOLD);
+  const GridGeometry& g = geometry;
+  int size = getOffset(9, g.cellSize, g.thick, g.thin, 0);
+  grid.geometry = geometry;
+  grid.area = cv::Rect(g.left, g.top, size, size) & cv::Rect(0, 0, screenshot.cols, screenshot.rows);
+  if (grid.area.width <= 0 || grid.area.height <= 0) {
+    return false;
+  }
+
+  if (screenshot.channels() == 1) {
+    grid.gray = screenshot(grid.area);
+  } else {
+    cv::cvtColor(screenshot(grid.area), grid.gray, cv::COLOR_BGR2GRAY);
+  }
+  binarizeGray(grid.gray, grid.binary);
+
+  // Линия перед ячейкой index занимает [getOffset - ширина, getOffset); index 9 — внешняя рамка
+  for (int index = 0; index <= 9; ++index) {
+    int width = index % 3 == 0 ? g.thick : g.thin;
+    int start = std::max(0, getOffset(index, g.cellSize, g.thick, g.thin, 0) - width - grid_line_guard);
+    int end = getOffset(index, g.cellSize, g.thick, g.thin, 0) + grid_line_guard;
+    if (start < grid.area.height) {
+      grid.binary(cv::Rect(0, start, grid.area.width, std::min(end, grid.area.height) - start)) = cv::Scalar(0);
+    }
+    if (start < grid.area.width) {
+      grid.binary(cv::Rect(start, 0, std::min(end, grid.area.width) - start, grid.area.height)) = cv::Scalar(0);
+    }
+  }
+  return true;
+}
+
+bool gridCell(const BinarizedGrid& grid, int row, int column, cv::Mat& gray, cv::Mat& binary) {
+  const GridGeometry& g = grid.geometry;
+  cv::Rect roi(getOffset(column, g.cellSize, g.thick, g.thin, 0), getOffset(row, g.cellSize, g.thick, g.thin, 0),
+               g.cellSize, g.cellSize);
+  roi = roi & cv::Rect(0, 0, grid.area.width, grid.area.height);
+  if (roi.width <= 0 || roi.height <= 0) {
+    return false;
+  }
+  gray = grid.gray(roi);
+  binary = grid.binary(roi);
+  return true;
+}
+
+// Шаблоны берутся из упакованного банка (mmap); PNG — запасной вариант,
+// если банк ещё не собран templateProcessingTool
+TemplateBank templateBank;
+
+bool loadTemplates(std::vector<cv::Mat>& templates) {
+  if (templateBank.open(template_bank_path) && templateBank.select(template_key, templates)) {
+    return true;
+  }
+  std::cerr << "Template bank " << template_bank_path << " has no complete set \"" << template_key
+            << "\", loading PNG templates" << std::endl;
+
+  templates.assign(10, cv::Mat());
+  for (int i = 0; i <= 9; ++i) {
+    templates[i] = cv::imread("templates_processed/" + std::to_string(i) + ".png", cv::IMREAD_GRAYSCALE);
+    if (i > 0 && templates[i].empty()) {
+      std::cerr << "Failed loading template " << i << std::endl;
+    }
+  }
+  return templateSetComplete(templates);
+}
+
+void matchDigitScores(const cv::Mat& binary, const std::vector<cv::Mat>& templates, double scores[10]) {
+  scores[0] = -1;
+  for (int i = 1; i <= 9; ++i) {
+    cv::Mat result;
+    cv::matchTemplate(binary, templates[i], result, cv::TM_CCOEFF_NORMED);
+    double minVal, maxVal;
+    cv::minMaxLoc(result, &minVal, &maxVal);
+    scores[i] = maxVal;
+  }
+}
+
+int matchDigit(const cv::Mat& binary, const std::vector<cv::Mat>& templates, double& bestScore) {
+  double scores[10];
+  matchDigitScores(binary, templates, scores);
+
+  int bestDigit = 0;
+  bestScore = -1;
+  for (int i = 1; i <= 9; ++i) {
+    if (scores[i] > bestScore) {
+      bestScore = scores[i];
+      bestDigit = i;
+    }
+  }
+
+  return bestScore > match_threshold ? bestDigit : 0;
+}
+
+int recognizeCell(const cv::Mat& cell, const std::vector<cv::Mat>& templates, double& confidence) {
+  DigitGuess ranked[OCR_TOP_K];
+  return recognizeCell(cell, templates, confidence, ranked);
+}
+
+int recognizeCell(const cv::Mat& cell, const std::vector<cv::Mat>& templates, double& confidence,
+                  DigitGuess ranked[OCR_TOP_K]) {
+  cv::Mat gray, binary;
+  {
+    TRACE_SCOPE(STAGE_THRESHOLD);
+    binarizeCell(cell, gray, binary);
+  }
+  return recognizeBinarizedCell(gray, binary, templates, confidence, ranked);
+}
+
+int recognizeBinarizedCell(const cv::Mat& gray, const cv::Mat& binary, const std::vector<cv::Mat>& templates,
+                           double& confidence, DigitGuess ranked[OCR_TOP_K]) {
+  bool empty;
+  {
+    TRACE_SCOPE(STAGE_THRESHOLD);
+    empty = isEmptyCell(gray, binary);
+  }
+
+  if (empty) {
+    confidence = 1.0;
+    for (int k = 0; k < OCR_TOP_K; ++k) {
+      ranked[k] = {0, k == 0 ? 1.0 : 0.0};
+    }
+    return 0;
+  }
+
+  double scores[10];
+  {
+    TRACE_SCOPE(STAGE_MATCH);
+    matchDigitScores(binary, templates, scores);
+  }
+
+  // Частичная сортировка цифр 1..9 по оценке
+  int order[9] = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+  std::partial_sort(order, order + OCR_TOP_K, order + 9, [&](int a, int b) { return scores[a] > scores[b]; });
+  for (int k = 0; k < OCR_TOP_K; ++k) {
+    ranked[k] = {order[k], std::max(scores[order[k]], 0.0)};
+  }
+
+  double bestScore = scores[order[0]];
+  int digit = bestScore > match_threshold ? order[0] : 0;
+  confidence = digit != 0 ? bestScore : 1.0 - std::max(bestScore, 0.0);
+  return digit;
+}
+
+bool recognizeBoard(const cv::Mat& screenshot, const std::string& layout,
+                    const std::vector<cv::Mat>& templates, ScannedBoard& board) {
+  if (!calibrateGrid(screenshot, layout)) {
+    std::cerr << "Grid not found, falling back to default geometry" << std::endl;
+  }
+
+  BinarizedGrid grid;
+  if (!binarizeGrid(screenshot, currentGridGeometry(), grid)) {
+    std::cerr << "Некорректная область обрезки (ROI)!" << std::endl;
+    return false;
+  }
+
+  for (int row = 0; row < 9; ++row) {
+    for (int column = 0; column < 9; ++column) {
+      cv::Mat gray, binary;
+      {
+        TRACE_SCOPE(STAGE_CROP);
+        if (!gridCell(grid, row, column, gray, binary)) {
+          std::cerr << "Некорректная область обрезки (ROI)!" << std::endl;
+          return false;
+        }
+      }
+      board.digits[row][column] = recognizeBinarizedCell(gray, binary, templates, board.confidence[row][column],
+                                                         board.ranked[row][column]);
+    }
+  }
+  return true;
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+// Распознавание судоку со скриншота: поиск сетки, нарезка ячеек,
+// бинаризация, отсев пустых ячеек и сопоставление с шаблонами.
+// Общий код для matchTemplate, ocrBench и sudokuGUI. Собирается в библиотеку
+// вместе с сессией устройства:
+//   g++ -c -O2 sudokuOcr.cpp deviceSession.cpp pipelineTrace.cpp `pkg-config --cflags opencv4`
+//   ar rcs libsudokuocr.a sudokuOcr.o deviceSession.o pipelineTrace.o
+//   g++ -std=c++17 -o matchTemplate matchTemplate.cpp batchScan.cpp ocrResolve.cpp sudokuEngine.cpp solveTrace.cpp libsudokuocr.a -pthread `pkg-config --cflags --libs opencv4`
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include "templateBank.h"
+#include "ocrResolve.h"
+
+// Результат распознавания доски
+struct ScannedBoard {
+  int digits[9][9];         // 0 — пустая ячейка
+  double confidence[9][9];  // 0..1: оценка шаблона для цифры, 1 — для отсеянной пустой ячейки
+  DigitGuess ranked[9][9][OCR_TOP_K];  // лучшие цифры по убыванию оценки; для пустой — {0, 1}
+};
+
+// Геометрия сетки на скриншоте, px (уточняется calibrateGrid)
+extern int cell_size;
+extern int thick;
+extern int thin;
+extern int margin_left;
+extern int margin_top;
+
+// Бинаризация: 0 — один порог Оцу на всю сетку, иначе локальный порог по
+// среднему в окне такого размера, px (около размера ячейки), со сдвигом offset
+extern int grid_adaptive_window;
+extern double grid_adaptive_offset;
+// Сколько пикселей стирать по обе стороны от каждой линии сетки
+extern int grid_line_guard;
+
+// Быстрый отсев пустых ячеек
+extern int empty_cell_inset;
+extern double empty_cell_min_stddev;
+extern int empty_cell_min_ink;
+
+// Сопоставление с шаблонами
+extern double match_threshold;
+extern std::string template_bank_path;
+extern std::string template_key;
+
+// Поиск сетки и кэш калибровки
+extern std::string calibration_path;
+extern double grid_line_min_fill;
+extern int grid_spacing_tolerance;
+
+int getOffset(int index, int cell_size, int thick, int thin, int margin);
+
+/**
+ * Finds the grid on a screenshot or takes it from the calibration cache
+ * keyed by resolution and layout. A cached geometry is re-verified on its
+ * thick-line pixels only; the whole screen is binarized just to detect the
+ * grid again. The cache file is read once per process. Leaves the
+ * compiled-in default geometry on failure.
+ */
+bool calibrateGrid(const cv::Mat& image, const std::string& layout);
+
+/**
+ * Takes grid geometry from the calibration cache without a screenshot
+ * (e.g. when only the device resolution is known)
+ */
+bool loadGridCalibration(int width, int height, const std::string& layout);
+
+/**
+ * Rectangle of a cell on the screenshot, clipped to the image
+ */
+cv::Rect cellRect(int row, int column, const cv::Mat& image);
+
+void binarizeCell(const cv::Mat& cell, cv::Mat& gray, cv::Mat& binary);
+
+/**
+ * Threshold used for cells, grids and templates alike: digits become white
+ * on black. Mode is chosen by grid_adaptive_window.
+ */
+void binarizeGray(const cv::Mat& gray, cv::Mat& binary);
+
+// Снимок геометрии сетки: её можно передать в другой поток, пока
+// глобальные параметры уже калибруются по следующему скриншоту
+struct GridGeometry {
+  int cellSize, thick, thin, left, top;
+};
+
+GridGeometry currentGridGeometry();
+
+// Вся сетка, бинаризованная за один проход; ячейки — окна в gray и binary
+struct BinarizedGrid {
+  GridGeometry geometry;
+  cv::Rect area;   // сетка на скриншоте, с внешней рамкой
+  cv::Mat gray;
+  cv::Mat binary;  // линии сетки стёрты
+};
+
+/**
+ * One grayscale conversion and one threshold over the grid area instead of
+ * one per cell, so every cell is cut by the same threshold; then clears the
+ * grid lines from the binary image
+ * @return false if the grid does not fit on the screenshot
+ */
+bool binarizeGrid(const cv::Mat& screenshot, const GridGeometry& geometry, BinarizedGrid& grid);
+
+/**
+ * Views (no copy) of one cell in a binarized grid
+ * @return false if the cell lies outside the screenshot
+ */
+bool gridCell(const BinarizedGrid& grid, int row, int column, cv::Mat& gray, cv::Mat& binary);
+
+/**
+ * Cheap check that a cell holds no digit: near-uniform or too little ink
+ */
+bool isEmptyCell(const cv::Mat& gray, const cv::Mat& binary);
+
+/**
+ * Loads templates (index = digit) from the template bank, or from
+ * templates_processed/<digit>.png if the bank has no such set
+ */
+bool loadTemplates(std::vector<cv::Mat>& templates);
+
+/**
+ * Scores a binarized cell against every template: scores[d] for d = 1..9
+ */
+void matchDigitScores(const cv::Mat& binary, const std::vector<cv::Mat>& templates, double scores[10]);
+
+/**
+ * Matches a binarized cell against digits 1-9
+ * @return recognized digit, or 0 if the best score is below match_threshold
+ */
+int matchDigit(const cv::Mat& binary, const std::vector<cv::Mat>& templates, double& bestScore);
+
+/**
+ * Binarizes a cropped BGR cell and recognizes it
+ * @param confidence how sure the recognizer is about the returned value (0..1)
+ * @return recognized digit, 0 for an empty or unreadable cell
+ */
+int recognizeCell(const cv::Mat& cell, const std::vector<cv::Mat>& templates, double& confidence);
+
+/**
+ * Same, also returning the top OCR_TOP_K digits by score for the resolver
+ */
+int recognizeCell(const cv::Mat& cell, const std::vector<cv::Mat>& templates, double& confidence,
+                  DigitGuess ranked[OCR_TOP_K]);
+
+/**
+ * Recognizes a cell that is already binarized (e.g. a view from gridCell)
+ */
+int recognizeBinarizedCell(const cv::Mat& gray, const cv::Mat& binary, const std::vector<cv::Mat>& templates,
+                           double& confidence, DigitGuess ranked[OCR_TOP_K]);
+
+/**
+ * Full in-memory pipeline for one screenshot: grid calibration, one
+ * binarization of the grid and recognition of all 81 cells, without
+ * writing any files
+ */
+bool recognizeBoard(const cv::Mat& screenshot, const std::string& layout,
+                    const std::vector<cv::Mat>& templates, ScannedBoard& board);
@@ -0,0 +1,272 @@
+#pragma once
+
+// Упакованный банк шаблонов цифр.
+//
+// templateProcessingTool записывает все бинаризованные шаблоны в один файл,
+// matchTemplate отображает его в память (mmap) и берёт cv::Mat прямо поверх
+// отображения, без imread/декодирования PNG на каждом запуске.
+//
+// В одном файле может лежать несколько наборов шаблонов (тема устройства,
+// разрешение), набор выбирается по ключу.
+//
+// Формат (все смещения — от начала файла, little-endian):
+//   BankHeader
+//   BankSetEntry[setCount]                — каталог наборов
+//   для каждого набора: BankGlyph[glyphCount], затем пиксели
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char BANK_MAGIC[4] = {'S', 'D', 'K', 'B'};
+static const uint32_t BANK_VERSION = 2;
+static const size_t BANK_KEY_SIZE = 32;
+static const size_t BANK_ALIGNMENT = 16;
+
+struct BankHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t setCount;
+  uint32_t reserved;
+};
+
+struct BankSetEntry {
+  char key[BANK_KEY_SIZE];
+  uint32_t glyphCount;
+  uint32_t reserved;
+  uint64_t glyphsOffset;
+};
+
+struct BankGlyph {
+  uint32_t digit;
+  uint32_t rows;
+  uint32_t cols;
+  uint32_t reserved;
+  uint64_t pixelsOffset;   // rows * cols байт, построчно без выравнивания
+};
+
+// Шаблоны одного набора: индекс — цифра, пустой cv::Mat — шаблона нет
+typedef std::vector<cv::Mat> TemplateSet;
+
+inline size_t alignBank(size_t offset) {
+  return (offset + BANK_ALIGNMENT - 1) / BANK_ALIGNMENT * BANK_ALIGNMENT;
+}
+
+// Для распознавания нужны шаблоны всех цифр 1-9; шаблон 0 необязателен
+inline bool templateSetComplete(const TemplateSet& templates) {
+  if (templates.size() < 10) {
+    return false;
+  }
+  for (int digit = 1; digit <= 9; ++digit) {
+    if (templates[digit].empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Записывает все наборы в файл. Шаблоны должны быть CV_8UC1, неполный набор
+// не записывается.
+inline bool writeTemplateBank(const std::string& path, const std::map<std::string, TemplateSet>& sets) {
+  std::vector<char> file;
+  auto put = [&file](size_t offset, const void* data, size_t size) {
+    if (file.size() < offset + size) {
+      file.resize(offset + size);
+    }
+    std::memcpy(file.data() + offset, data, size);
+  };
+
+  BankHeader header = {};
+  std::memcpy(header.magic, BANK_MAGIC, sizeof(BANK_MAGIC));
+  header.version = BANK_VERSION;
+  header.setCount = sets.size();
+  put(0, &header, sizeof(header));
+
+  size_t entryOffset = sizeof(BankHeader);
+  size_t offset = alignBank(entryOffset + sets.size() * sizeof(BankSetEntry));
+
+  for (const auto& set : sets) {
+    if (set.first.size() >= BANK_KEY_SIZE) {
+      return false;
+    }
+    if (!templateSetComplete(set.second)) {
+      return false;
+    }
+
+    std::vector<int> digits;
+    for (size_t digit = 0; digit < set.second.size(); ++digit) {
+      if (!set.second[digit].empty()) {
+        digits.push_back(digit);
+      }
+    }
+
+    BankSetEntry entry = {};
+    std::strncpy(entry.key, set.first.c_str(), BANK_KEY_SIZE - 1);
+    entry.glyphCount = digits.size();
+    entry.glyphsOffset = offset;
+    put(entryOffset, &entry, sizeof(entry));
+    entryOffset += sizeof(entry);
+
+    size_t glyphOffset = offset;
+    offset = alignBank(offset + digits.size() * sizeof(BankGlyph));
+
+    for (int digit : digits) {
+      const cv::Mat& binary = set.second[digit];
+      BankGlyph glyph = {};
+      glyph.digit = digit;
+      glyph.rows = binary.rows;
+      glyph.cols = binary.cols;
+
+      glyph.pixelsOffset = offset;
+      for (int row = 0; row < binary.rows; ++row) {
+        put(offset, binary.ptr<uchar>(row), binary.cols);
+        offset += binary.cols;
+      }
+      offset = alignBank(offset);
+
+      put(glyphOffset, &glyph, sizeof(glyph));
+      glyphOffset += sizeof(glyph);
+    }
+  }
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(file.data(), file.size());
+  return static_cast<bool>(out);
+}
+
+// Банк, отображённый в память. cv::Mat из select() ссылаются на отображение
+// и живут, пока жив объект TemplateBank.
+class TemplateBank {
+public:
+  TemplateBank() : data(nullptr), size(0) {}
+
+  ~TemplateBank() {
+    close();
+  }
+
+  TemplateBank(const TemplateBank&) = delete;
+  TemplateBank& operator=(const TemplateBank&) = delete;
+
+  bool open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(BankHeader))) {
+      ::close(fd);
+      return false;
+    }
+
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+      return false;
+    }
+
+    data = static_cast<const char*>(mapped);
+    size = info.st_size;
+
+    const BankHeader* header = reinterpret_cast<const BankHeader*>(data);
+    if (std::memcmp(header->magic, BANK_MAGIC, sizeof(BANK_MAGIC)) != 0 ||
+        header->version != BANK_VERSION ||
+        sizeof(BankHeader) + header->setCount * sizeof(BankSetEntry) > size) {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  void close() {
+    if (data) {
+      munmap(const_cast<char*>(data), size);
+      data = nullptr;
+      size = 0;
+    }
+  }
+
+  std::vector<std::string> keys() const {
+    std::vector<std::string> result;
+    for (uint32_t i = 0; i < setCount(); ++i) {
+      result.push_back(entry(i)->key);
+    }
+    return result;
+  }
+
+  // Возвращает глифы набора или nullptr, если ключа нет
+  const BankGlyph* glyphs(const std::string& key, uint32_t& count) const {
+    for (uint32_t i = 0; i < setCount(); ++i) {
+      const BankSetEntry* set = entry(i);
+      if (key == set->key && set->glyphsOffset + set->glyphCount * sizeof(BankGlyph) <= size) {
+        count = set->glyphCount;
+        return reinterpret_cast<const BankGlyph*>(data + set->glyphsOffset);
+      }
+    }
+    count = 0;
+    return nullptr;
+  }
+
+  // false, если ключа нет или в наборе не хватает какой-то из цифр 1-9
+  bool select(const std::string& key, TemplateSet& templates) const {
+    uint32_t count;
+    const BankGlyph* glyph = glyphs(key, count);
+    if (!glyph) {
+      return false;
+    }
+
+    templates.assign(10, cv::Mat());
+    for (uint32_t i = 0; i < count; ++i, ++glyph) {
+      if (glyph->digit > 9 || glyph->pixelsOffset + glyph->rows * glyph->cols > size) {
+        return false;
+      }
+      templates[glyph->digit] = cv::Mat(glyph->rows, glyph->cols, CV_8UC1,
+                                        const_cast<char*>(data + glyph->pixelsOffset));
+    }
+    return templateSetComplete(templates);
+  }
+
+private:
+  uint32_t setCount() const {
+    return data ? reinterpret_cast<const BankHeader*>(data)->setCount : 0;
+  }
+
+  const BankSetEntry* entry(uint32_t index) const {
+    return reinterpret_cast<const BankSetEntry*>(data + sizeof(BankHeader)) + index;
+  }
+
+  const char* data;
+  size_t size;
+};
+
+// Читает все наборы банка в память (копии), чтобы дописать или заменить один из них
+inline bool readTemplateBank(const std::string& path, std::map<std::string, TemplateSet>& sets) {
+  TemplateBank bank;
+  if (!bank.open(path)) {
+    return false;
+  }
+  for (const std::string& key : bank.keys()) {
+    TemplateSet mapped;
+    if (!bank.select(key, mapped)) {
+      return false;
+    }
+    TemplateSet& copy = sets[key];
+    copy.assign(mapped.size(), cv::Mat());
+    for (size_t digit = 0; digit < mapped.size(); ++digit) {
+      if (!mapped[digit].empty()) {
+        copy[digit] = mapped[digit].clone();
+      }
+    }
+  }
+  return true;
+}
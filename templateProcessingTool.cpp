@@ -1,12 +1,21 @@
+// Сборка:
+//   g++ -std=c++17 -o templateProcessingTool templateProcessingTool.cpp libsudokuocr.a -pthread `pkg-config --cflags --libs opencv4`
+
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include <filesystem>
+#include "templateBank.h"
+#include "sudokuOcr.h"
 
 namespace fs = std::filesystem;
 
-int main() {
+int main(int argc, char** argv) {
+    // Ключ набора в банке шаблонов (тема устройства, разрешение)
+    std::string bank_key = argc > 1 ? argv[1] : "default";
     // Путь к папке с исходными изображениями
-    std::string input_folder = "templates_raw/";
+    std::string input_folder = argc > 2 ? argv[2] : "templates_raw/";
+    // Упакованный банк, который читает matchTemplate
+    std::string bank_path = "templates.bank";
     // Путь к папке, куда сохранять обработанные
     std::string output_folder = "templates_processed/";
 
@@ -15,6 +24,8 @@ int main() {
         fs::create_directory(output_folder);
     }
 
+    TemplateSet templates(10);
+
     // Обрабатываем каждое изображение от 0 до 9
     for (int i = 0; i <= 9; ++i) {
         std::string filename = "" + std::to_string(i) + ".png";
@@ -28,18 +39,34 @@ int main() {
             continue;
         }
 
-        // Преобразуем в градации серого
-        cv::Mat gray;
-        cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
-
-        // Бинаризуем с инверсией и автоматическим порогом Оцу
-        cv::Mat binary;
-        cv::threshold(gray, binary, 0, 255, cv::THRESH_BINARY_INV | cv::THRESH_OTSU);
+        // Тот же порог, что и для ячеек сетки (sudokuOcr), иначе шаблоны и
+        // ячейки бинаризуются по-разному
+        cv::Mat gray, binary;
+        binarizeCell(img, gray, binary);
 
         // Сохраняем результат
         cv::imwrite(output_path, binary);
         std::cout << "Сохранено: " << output_path << std::endl;
+
+        templates[i] = binary;
+    }
+
+    // Без любой из цифр 1-9 распознавание не работает, неполный набор в банк не пишем
+    if (!templateSetComplete(templates)) {
+        std::cerr << "Нет шаблонов всех цифр 1-9, банк не изменён: " << bank_path << std::endl;
+        return 1;
+    }
+
+    // Дописываем набор в банк, сохраняя остальные наборы
+    std::map<std::string, TemplateSet> sets;
+    readTemplateBank(bank_path, sets);
+    sets[bank_key] = templates;
+
+    if (!writeTemplateBank(bank_path, sets)) {
+        std::cerr << "Не удалось записать банк шаблонов: " << bank_path << std::endl;
+        return 1;
     }
+    std::cout << "Набор \"" << bank_key << "\" записан в " << bank_path << std::endl;
 
     std::cout << "Обработка завершена!" << std::endl;
     return 0;
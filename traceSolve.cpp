@@ -0,0 +1,99 @@
+// Записывает журнал решения головоломки выбранным решателем в тот же
+// текстовый формат, что кнопка Save trace в sudokuGUI, чтобы сравнить
+// решатели через diff или открыть журнал в GUI (Load trace).
+//
+// Сборка:
+//   g++ -O2 -o traceSolve traceSolve.cpp sudokuEngine.cpp solveTrace.cpp
+//
+// Запуск:
+//   ./traceSolve [--engine backtracking|bitmask] [--output solve_trace.txt] [puzzle]
+//
+// puzzle — 81 символ ('0' или '.' для пустых) или файл в формате sudoku.txt;
+// по умолчанию sudoku.txt.
+//
+// Сравнение:
+//   ./traceSolve --engine backtracking --output bt.txt p.txt
+//   ./traceSolve --engine bitmask --output bm.txt p.txt
+//   diff bt.txt bm.txt | head
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "sudokuEngine.h"
+#include "solveTrace.h"
+
+bool loadPuzzle(const std::string& source, int puzzle[9][9]) {
+  // Строка из 81 клетки или файл (9 строк по 9 цифр, как sudoku.txt)
+  if (parse_puzzle(source, puzzle)) {
+    return true;
+  }
+  std::ifstream file(source);
+  std::string text, line;
+  while (std::getline(file, line)) {
+    text += line;
+  }
+  if (!file.eof() || !parse_puzzle(text, puzzle)) {
+    std::cerr << "Failed reading puzzle from " << source << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  std::string engine = "backtracking";
+  std::string outputPath = "solve_trace.txt";
+  std::string source = "sudoku.txt";
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--engine" && i + 1 < argc) {
+      engine = argv[++i];
+    } else if (arg == "--output" && i + 1 < argc) {
+      outputPath = argv[++i];
+    } else {
+      source = arg;
+    }
+  }
+
+  int puzzle[9][9];
+  if (!loadPuzzle(source, puzzle)) {
+    return 1;
+  }
+  if (!is_valid_board(puzzle)) {
+    std::cerr << "The givens conflict" << std::endl;
+    return 1;
+  }
+
+  // Кольцо никто не читает, нужна только полная запись
+  SolveTrace trace(1);
+  trace.reset(true);
+  bool solved;
+  if (engine == "backtracking") {
+    BacktrackingSolver solver;
+    solver.load(puzzle);
+    solver.set_trace(&trace);
+    solved = solver.solve();
+  } else if (engine == "bitmask") {
+    BitmaskSolver solver;
+    solver.load(puzzle);
+    solver.set_trace(&trace);
+    solved = solver.solve();
+  } else {
+    std::cerr << "Unknown engine " << engine << ", expected backtracking or bitmask" << std::endl;
+    return 1;
+  }
+
+  std::vector<SolveEvent> events;
+  trace.take_recording(events);
+  if (trace.recording_truncated()) {
+    std::cerr << "Trace truncated, only the first " << events.size() << " events were recorded" << std::endl;
+  }
+  if (!save_trace(outputPath, engine, puzzle, events)) {
+    std::cerr << "Failed writing " << outputPath << std::endl;
+    return 1;
+  }
+  std::cout << engine << ": " << (solved ? "solved" : "no solution") << ", " << events.size()
+            << " events written to " << outputPath << std::endl;
+  return solved ? 0 : 2;
+}